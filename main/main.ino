@@ -4,14 +4,17 @@
 
 #include "src/ControllerConfig.h"
 #include "src/Utils/DataSaver.h"
+#include "src/Utils/ChangeTracker.h"
+#include "src/Utils/Timebase.h"
 #include "src/Irrigation/IrrigationController.h"
 #include "src/Irrigation/ElectrovalvesControlThread.h"
 #include "src/SwimmingPool/SwimmingPoolController.h"
 #include "src/TaskScheduler/TaskSchedulerThread.h"
+#include "src/TaskScheduler/TimedThreadController.h"
 #include "src/Communication/CommunicationsThread.h"
 
-// Initialise thread controller
-ThreadController threadController = ThreadController();
+// Initialise thread controller (keeps the loop timing statistics)
+TimedThreadController* threadController = new TimedThreadController();
 
 // Clock
 RTC_DS3231 rtc;
@@ -27,23 +30,30 @@ void setup() {
   }
 
   // Shared objects
-  DataSaver* dataSaver = new DataSaver();  //TODO VALIDATE LOADED DATA
+  // NOTE: the objects hold references to these pointers, which must therefore outlive setup() (static)
+  static DataSaver*     dataSaver     = new DataSaver();  //TODO VALIDATE LOADED DATA
+  static ChangeTracker* changeTracker = new ChangeTracker(dataSaver->incrementBootCount());
+  static Timebase*      timebase      = new Timebase(rtc);
 
-  ElectrovalvesControlThread* electrovavlesThread = new ElectrovalvesControlThread();
+  static ElectrovalvesControlThread* electrovavlesThread = new ElectrovalvesControlThread(changeTracker);
 
   // Initialise controllers and task scheduler
-  IrrigationController*   irrigationController   = new IrrigationController(electrovavlesThread, dataSaver, rtc);
-  SwimmingPoolController* swimmingPoolController = new SwimmingPoolController(dataSaver);
+  static IrrigationController*   irrigationController   = new IrrigationController(electrovavlesThread, dataSaver, changeTracker, timebase);
+  static SwimmingPoolController* swimmingPoolController = new SwimmingPoolController(dataSaver, changeTracker);
 
-  Task* tasks[2] = {irrigationController, swimmingPoolController};
-  TaskSchedulerThread<2>* taskSchedulerThread = new TaskSchedulerThread<2>(tasks, rtc);
+  static TaskSchedulerThread* taskSchedulerThread = new TaskSchedulerThread(timebase, changeTracker);
+  taskSchedulerThread->addTask(irrigationController);
+  taskSchedulerThread->addTask(swimmingPoolController);
 
   // Communications Thread
-  CommunicationsThread* communicationsThread = new CommunicationsThread(
+  static CommunicationsThread* communicationsThread = new CommunicationsThread(
     electrovavlesThread,
     taskSchedulerThread,
+    threadController,
     irrigationController,
-    swimmingPoolController
+    swimmingPoolController,
+    dataSaver,
+    changeTracker
   );
 
   // Initialise memory if not initialised
@@ -55,19 +65,21 @@ void setup() {
   }
 
   // Start threads and set intervals
-	threadController.add(electrovavlesThread);
-	threadController.add(taskSchedulerThread);
-	threadController.add(communicationsThread);
+	threadController->add(electrovavlesThread);
+	threadController->add(taskSchedulerThread);
+	threadController->add(communicationsThread);
 
   electrovavlesThread->setInterval(1);
-  taskSchedulerThread->setInterval(1);
   communicationsThread->setInterval(1);
 
   delay(1000); // Wait for pinmodes to establish
+
+  threadController->reset(); // Do not account the setup time in the loop timing statistics
 }
 
 
 void loop() {
   // Run threads
-  threadController.run();
+  threadController->run();
+  threadController->sleepUntilDue();
 }
@@ -0,0 +1,91 @@
+/*
+  CommunicationStatistics.h
+
+  Keeps track of the communication link counters (see LinkStatistics) and of the request count, error count and
+  handling time of every instruction (see InstructionStatistics).
+
+  To keep the RAM usage bounded, the instruction statistics are stored in a fixed-size table of 
+  COMM_STATISTICS_SLOTS slots, which are assigned to the instructions in the order in which they are first requested.
+  Once the table is full, requests of other instructions are only counted as untracked requests.
+  The statistics are not persisted, and are cleared on boot or with the RESET_COMM_STATS_ADDR instruction.
+*/
+#ifndef CommunicationStatistics_h
+#define CommunicationStatistics_h
+
+#include <Arduino.h>
+
+#include "../ControllerConfig.h"
+#include "CommunicationsTypes.h"
+
+class CommunicationStatistics
+{
+    public:
+        CommunicationStatistics() {
+            reset();
+        }
+
+        void reset() {
+            memset(&link, 0, sizeof(LinkStatistics));
+            memset(instructions, 0, sizeof(instructions));
+            instructionsCount = 0;
+        }
+
+        // Link counters
+        void recordByteReceived()     { if (link.bytesReceived    < 0xFFFFFFFF) link.bytesReceived++; }
+        void recordByteSent()         { if (link.bytesSent        < 0xFFFFFFFF) link.bytesSent++;     }
+        void recordCrcError()         { if (link.crcErrors        < 0xFFFF) link.crcErrors++;        }
+        void recordFramingError()     { if (link.framingErrors    < 0xFFFF) link.framingErrors++;    }
+        void recordTimeout()          { if (link.timeouts         < 0xFFFF) link.timeouts++;         }
+        void recordRejectedRequest()  { if (link.rejectedRequests < 0xFFFF) link.rejectedRequests++; }
+        void recordRxOverrun()        { if (link.rxOverruns       < 0xFFFF) link.rxOverruns++;       }
+
+        void recordInstruction(const uint8_t code, const bool success, const uint32_t elapsedTime) {
+            if (link.requestsHandled < 0xFFFF) link.requestsHandled++;
+
+            InstructionStatistics* slot = findSlot(code);
+            if (slot == nullptr) {
+                if (link.untrackedRequests < 0xFFFF) link.untrackedRequests++;
+                return;
+            }
+
+            const uint16_t time = min(elapsedTime, (uint32_t) 0xFFFF);
+            if (time > slot->maxTime) slot->maxTime = time;
+
+            // The counters of the slot saturate together, so that the average time and the error rate remain exact
+            if (slot->count == 0xFFFF || slot->totalTime > 0xFFFFFFFF - elapsedTime) return;
+
+            slot->count++;
+            slot->totalTime += elapsedTime;
+            if (!success) slot->errors++;
+        }
+
+        const LinkStatistics& getLink() {
+            return link;
+        }
+
+        uint8_t getInstructionsCount() {
+            return instructionsCount;
+        }
+
+        const InstructionStatistics& getInstruction(const uint8_t slotIdx) {
+            return instructions[slotIdx];
+        }
+
+    private:
+        LinkStatistics        link;
+        InstructionStatistics instructions[COMM_STATISTICS_SLOTS];
+        uint8_t               instructionsCount;
+
+        InstructionStatistics* findSlot(const uint8_t code) {
+            for (uint8_t i = 0; i < instructionsCount; i++) {
+                if (instructions[i].code == code) return &instructions[i];
+            }
+
+            if (instructionsCount == COMM_STATISTICS_SLOTS) return nullptr;
+
+            instructions[instructionsCount].code = code;
+            return &instructions[instructionsCount++];
+        }
+};
+
+#endif
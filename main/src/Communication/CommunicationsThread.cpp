@@ -1,20 +1,62 @@
 #include "CommunicationsThread.h"
 
 #include "ProtocolDefinition.h"
+#include "InstructionTable.h"
 #include "../PinDefinitions.h"
 
-static uint8_t payloadAndParity;
+// GET instruction that returns the value of each ChangeField (except for the irrigation group fields)
+static const uint8_t changeFieldInstructions[] PROGMEM = {
+  GET_AUTO_VALUE_ADDR,
+
+  SP_GET_CONTROLLER_STATE_ADDR,
+  SP_GET_PUMP_STATE_ADDR,
+  SP_GET_UV_STATE_ADDR,
+  SP_GET_PUMP_MANUAL_VALUE_ADDR,
+  SP_GET_UV_ENABLE_VALUE_ADDR,
+  SP_GET_FLOW_SENSOR_VALUE_ADDR,
+  SP_GET_PUMP_MANUAL_DISABLE_ADDR,
+  SP_GET_SCHEDULE_ENABLE_ADDR,
+  SP_GET_SCHEDULE_NEXT_ADDR,
+  SP_GET_SCHEDULE_DURATION_ADDR,
+  SP_GET_SCHEDULE_PERIOD_ADDR,
+
+  IRR_GET_CONTROLLER_STATE_ADDR,
+  IRR_GET_PUMP_STATE_ADDR,
+  IRR_GET_MAINS_INLET_STATE_ADDR,
+  IRR_GET_MANUAL_VALUE_ADDR,
+  IRR_GET_PRESSURE_SENSOR_VALUE_ADDR,
+  IRR_GET_MANUAL_DISABLE_STATE_ADDR,
+  IRR_GET_ZONES_STATE_ADDR,
+  IRR_GET_MANUAL_ZONES_ADDR,
+  IRR_GET_MANUAL_SOURCE_ADDR,
+  IRR_GET_SCHEDULE_ENABLE_ADDR,
+  IRR_GET_SCHEDULE_PAUSED_STATE_ADDR,
+  IRR_GET_SCHEDULE_RESUME_TIME_ADDR,
+  IRR_GET_NEXT_IRRIGATION_TIME_ADDR,
+  IRR_GET_SCHEDULE_GROUPS_STATE_ADDR,
+  IRR_GET_DROPPED_JOBS_ADDR
+};
+
+static_assert(PLC_NODE_ADDRESS != COMM_BROADCAST_ADDRESS, "The node address must not be the broadcast address");
+
+static_assert(sizeof(changeFieldInstructions) == CHANGE_FIELD_IRR_GROUP_0, "A GET instruction must be defined for every ChangeField");
 
 CommunicationsThread::CommunicationsThread(
   ElectrovalvesControlThread*& electrovavlesThread,
-  TaskSchedulerThread<2>*&     taskSchedulerThread,
+  TaskSchedulerThread*&        taskSchedulerThread,
+  TimedThreadController*&      threadController,
   IrrigationController*&       irrigationController,
-  SwimmingPoolController*&     swimmingPoolController
+  SwimmingPoolController*&     swimmingPoolController,
+  DataSaver*&                  dataSaver,
+  ChangeTracker*&              changeTracker
 ) :
   electrovavlesThread(electrovavlesThread),
   taskSchedulerThread(taskSchedulerThread),
+  threadController(threadController),
   irrigationController(irrigationController),
   swimmingPoolController(swimmingPoolController),
+  dataSaver(dataSaver),
+  changeTracker(changeTracker),
   max485(new MAX485(COMM_SERIAL, COMM_TRANSMISSION_ENABLE_PIN, 19200, SERIAL_8N1, 50, 50))
 {
     max485->begin();
@@ -24,326 +66,659 @@ CommunicationsThread::CommunicationsThread(
 
 void CommunicationsThread::run() {
 
-  // If no request is being actively handled, check for new requests
-  if (requestCode == 0) {
-    if (max485->available() > 0) { 
-      // If a new request is received, wait for the first 2 bytes (instruction code + payload/parity)
-      if (requestTimestamp == 0) requestTimestamp = millis();
-      else if ((millis() - requestTimestamp) > TIMEOUT_PER_PACKET) { // Timed out receiveing the instruction payload+parity bit
-        requestCode      = 0;
-        requestTimestamp = 0;
-        while (max485->available()) max485->read(); // Clear receive buffer
-      }
+  // Keep sending the pending response (if any). New requests are not parsed until the response has been sent, as the 
+  // bus is half-duplex and the Tx payload buffer is in use
+  if (responseState != ResponseState::IDLE) {
+    transmitResponse();
+    runned();
+    return;
+  }
+
+  // Parse the received bytes as they arrive. Complete requests are added to the request queue
+  while (max485->available() > 0) {
+    receiveByte(max485->read());
+    statistics.recordByteReceived();
+  }
 
-      // Once the instruction, payload size and parity check have been received, read the data
-      if (max485->available() >= 2) {
-        requestCode        = max485->read();
-        payloadAndParity   = max485->read();
+  // Abandon the request if the next byte is not received in time
+  if (requestState != RequestState::IDLE && (millis() - requestTimestamp) > TIMEOUT_PER_PACKET) {
+    statistics.recordTimeout();
 
-        requestParityBit   = (payloadAndParity & 0x80) != 0;                      // Get the first bit (parity bit)
-        requestPayloadSize = payloadAndParity & 0x7F;                             // Ignore the first bit (parity bit)
-        requestDataTimeout = ((uint32_t) requestPayloadSize)*TIMEOUT_PER_PACKET;  // Calculate the timeout for the entire request
-      }
+    // Legacy frames: clear the received data. CRC frames: the received data is discarded until the next start of frame
+#if COMM_LEGACY_FRAMING_ENABLED
+    if (receivedRequest.frameFormat == FrameFormat::LEGACY) {
+      while (max485->available() > 0) max485->read();
     }
+#endif
+    resetRequest();
   }
-  else { // If a request is being actively handled, wait for the request payload
-    bool allPacketsReceived = max485->available() >= requestPayloadSize + 1; // Expect an extra null character at the end of the response
-    bool timedOut           = !allPacketsReceived && ((millis() - requestTimestamp) >= requestDataTimeout);
 
-    if (allPacketsReceived) {
-      // Write received packets to the rxPayloadBuffer     //TODO make sure requestPayloadSize is no larger than the buffer size
-      for (uint8_t i = 0; i < requestPayloadSize; i++) {
-        rxPayloadBuffer[i] = max485->read();
+  // Handle the next queued request once the bus is idle, as responding whilst the client is transmitting would collide
+  if (
+    requestQueueCount > 0                 &&
+    requestState == RequestState::IDLE    &&
+    max485->available() == 0              &&
+    (millis() - requestTimestamp) >= COMM_RESPONSE_DELAY
+  ) {
+    handleNextRequest();
+  }
+
+  runned();
+}
+
+void CommunicationsThread::receiveByte(const uint8_t byte) {
+  requestTimestamp = millis();
+
+  switch (requestState) {
+    case RequestState::IDLE: // Wait for the start of a new request
+      if (byte == FRAME_START_MARKER || byte == FRAME_SEQ_START_MARKER) {
+        receivedRequest.frameFormat = FrameFormat::CRC;
+        receivedRequest.hasSequence = byte == FRAME_SEQ_START_MARKER;
+        requestCrc                  = CRC16_INITIAL_VALUE;
+        requestState                = RequestState::ADDRESS;
       }
+#if COMM_LEGACY_FRAMING_ENABLED
+      else if (byte != 0) { // Skip stray NULL characters
+        receivedRequest.frameFormat = FrameFormat::LEGACY;
+        receivedRequest.address     = PLC_NODE_ADDRESS;    // Legacy frames are not addressed
+        receivedRequest.code        = byte;
+        requestParity               = byte;
+        requestState                = RequestState::SIZE;
+      }
+#endif
+      // Any other byte is discarded until a start of frame is found
+      return;
+
+    case RequestState::ADDRESS:
+      receivedRequest.address = byte;
+      requestCrc              = crc16Update(requestCrc, byte);
+      requestState            = receivedRequest.hasSequence ? RequestState::SEQUENCE : RequestState::CODE;
+      return;
+
+    case RequestState::SEQUENCE:
+      receivedRequest.sequence = byte;
+      requestCrc               = crc16Update(requestCrc, byte);
+      requestState             = RequestState::CODE;
+      return;
 
-      // Expect extra null character at the end of the payload
-      if (max485->read() != 0) {
-        //TODO ERROR?
+    case RequestState::CODE:
+      receivedRequest.code = byte;
+      requestCrc           = crc16Update(requestCrc, byte);
+      requestState         = RequestState::SIZE;
+      return;
+
+    case RequestState::SIZE:
+      if (receivedRequest.frameFormat == FrameFormat::CRC) {
+        receivedRequest.payloadSize = byte;
+        requestCrc                  = crc16Update(requestCrc, byte);
+      }
+      else {
+        requestParityBit            = (byte & 0x80) != 0;  // Get the first bit (parity bit)
+        receivedRequest.payloadSize = byte & 0x7F;         // Ignore the first bit (parity bit)
+        requestParity              ^= receivedRequest.payloadSize;
       }
-      
-      // Check parity - If the request parity (checkRequestParity()) is even (true), the parity check bit (requestParityBit) should be 0 (false)
-      if (!checkRequestParity() == requestParityBit) handleRequest(requestCode);
-    }
 
-    if (timedOut) {
-      //TODO THROW ERROR? NOTE ERROR SOMEWHERE?
+      receivedRequest.payloadOffset = rxPayloadBufferUsed;
 
-      // Clear received data
-      while (max485->available() > 0) max485->read();
-    }
+      if (!validateRequestHeader()) {
+        // Skip the rest of the frame without storing it (frames addressed to other nodes are skipped silently). The 
+        // request is rejected once the frame has been received, as responding whilst the client is still transmitting 
+        // would collide on the bus
+        requestState           = RequestState::DISCARD;
+        requestPayloadReceived = 0;
+        return;
+      }
+
+      if (receivedRequest.payloadSize > 0)                      requestState = RequestState::PAYLOAD;
+      else if (receivedRequest.frameFormat == FrameFormat::CRC) requestState = RequestState::CRC_HIGH;
+      else                                                      requestState = RequestState::TERMINATOR;
+      return;
 
-    if (allPacketsReceived || timedOut) {
-      // Reset the variables state after request complition/timeout
-      requestTimestamp    = 0;
-      requestCode         = 0;
-      requestParityBit  = false;
-      requestPayloadSize  = 0;
-      requestDataTimeout  = 0;
-      responsePayloadSize = 0;
-    }}
+    case RequestState::PAYLOAD:
+      // Write received packets to the free space of the rxPayloadBuffer (checked by 'validateRequestHeader')
+      rxPayloadBuffer[receivedRequest.payloadOffset + requestPayloadReceived++] = byte;
+      if (receivedRequest.frameFormat == FrameFormat::CRC) requestCrc = crc16Update(requestCrc, byte);
+      else                                                 requestParity ^= byte;
 
-  runned();
+      if (requestPayloadReceived == receivedRequest.payloadSize) {
+        requestState = receivedRequest.frameFormat == FrameFormat::CRC ? RequestState::CRC_HIGH : RequestState::TERMINATOR;
+      }
+      return;
+
+    case RequestState::CRC_HIGH:
+      requestReceivedCrc = ((uint16_t) byte) << 8;
+      requestState       = RequestState::CRC_LOW;
+      return;
+
+    case RequestState::CRC_LOW:
+      requestReceivedCrc |= byte;
+      requestState        = RequestState::TERMINATOR;
+      return;
+
+    case RequestState::DISCARD:
+      // Skip the payload, CRC (CRC frames) and trailing NULL character
+      if (
+        ++requestPayloadReceived < 
+        receivedRequest.payloadSize + (receivedRequest.frameFormat == FrameFormat::CRC ? 3 : 1)
+      ) return;
+
+      if (receivedRequest.nakReason != 0) queueReceivedRequest();
+      resetRequest();
+      return;
+
+    case RequestState::TERMINATOR:
+      // Expect an extra null character at the end of the frame (otherwise the frame boundaries cannot be trusted)
+      if (byte != 0) {
+        receivedRequest.nakReason = NAK_REASON_FRAMING;
+        statistics.recordFramingError();
+        queueReceivedRequest();
+        resetRequest();
+        return;
+      }
+
+      bool valid;
+      if (receivedRequest.frameFormat == FrameFormat::CRC) {
+        valid = requestCrc == requestReceivedCrc;
+      }
+      else {
+        // Check parity - If the request parity (XOR of every byte) is even (true), the parity check bit (requestParityBit) should be 0 (false)
+        valid = !checkParity(&requestParity) == requestParityBit;
+      }
+
+      if (!valid) {
+        receivedRequest.nakReason = NAK_REASON_CRC;
+        statistics.recordCrcError();
+      }
+      queueReceivedRequest();
+
+      resetRequest();
+      return;
+  }
+}
+
+bool CommunicationsThread::validateRequestHeader() {
+  // Reject unknown instructions and requests with an unexpected payload size (or that do not fit in the Rx buffer)
+  // without waiting for the payload
+  InstructionDefinition instruction;
+
+  if (
+    receivedRequest.address != PLC_NODE_ADDRESS && 
+    receivedRequest.address != COMM_BROADCAST_ADDRESS
+  ) return false;
+
+  if (requestQueueCount == COMM_RX_QUEUE_LENGTH) { // The request is dropped, the client will time out
+    statistics.recordRxOverrun();
+    return false;
+  }
+
+  if (
+    !findInstruction(receivedRequest.code, instruction) || (
+      receivedRequest.address == COMM_BROADCAST_ADDRESS &&
+      !(instruction.flags & INSTRUCTION_BROADCAST)
+    )
+  ) {
+    receivedRequest.nakReason = NAK_REASON_UNKNOWN;
+    statistics.recordRejectedRequest();
+    return false;
+  }
+
+  if (
+    receivedRequest.payloadSize > rxPayloadBufferSize || (
+      instruction.requestSize != INSTRUCTION_VARIABLE_SIZE &&
+      instruction.requestSize != receivedRequest.payloadSize
+    )
+  ) {
+    receivedRequest.nakReason = NAK_REASON_LENGTH;
+    statistics.recordRejectedRequest();
+    return false;
+  }
+
+  // The payloads of the queued requests are stored sequentially in the Rx buffer
+  if (receivedRequest.payloadSize > rxPayloadBufferSize - rxPayloadBufferUsed) {
+    receivedRequest.nakReason = NAK_REASON_BUSY;
+    statistics.recordRxOverrun();
+    return false;
+  }
+
+  return true;
+}
+
+void CommunicationsThread::queueReceivedRequest() {
+  // Drop the rejected requests that cannot be responded (legacy and broadcast requests)
+  if (
+    receivedRequest.nakReason != 0 && (
+      receivedRequest.frameFormat == FrameFormat::LEGACY ||
+      receivedRequest.address != PLC_NODE_ADDRESS
+    )
+  ) return;
+
+  requestQueue[(requestQueueHead + requestQueueCount) % COMM_RX_QUEUE_LENGTH] = receivedRequest;
+  requestQueueCount++;
+
+  if (receivedRequest.nakReason == 0) rxPayloadBufferUsed += receivedRequest.payloadSize;
+}
+
+void CommunicationsThread::resetRequest() {
+  // Reset the variables state after request complition/timeout (the request timestamp is kept to detect the bus idle time)
+  requestState           = RequestState::IDLE;
+  receivedRequest        = {};
+  requestParityBit       = false;
+  requestParity          = 0;
+  requestCrc             = CRC16_INITIAL_VALUE;
+  requestReceivedCrc     = 0;
+  requestPayloadReceived = 0;
 }
 
 
 
 // Request handling functions ***************************************************************************************************
 
-void CommunicationsThread::handleRequest(uint8_t requestCode) {
-  uint8_t groupIdx;
-  IrrigationGroupName tempGroupNameBuff;
+void CommunicationsThread::handleNextRequest() {
+  activeRequest     = requestQueue[requestQueueHead];
+  requestQueueHead  = (requestQueueHead + 1) % COMM_RX_QUEUE_LENGTH;
+  requestQueueCount--;
+
+  if (activeRequest.nakReason != 0) sendNak(activeRequest.nakReason);
+  else                              handleRequest();
+
+  // Free the Rx buffer once every queued request has been handled
+  if (requestQueueCount == 0) rxPayloadBufferUsed = 0;
+}
 
+void CommunicationsThread::handleRequest() {
   // Reset the read pointers to the Rx/Tx buffers
-  rxPayloadBufferNextPtr = rxPayloadBuffer;
+  rxPayloadBufferNextPtr = rxPayloadBuffer + activeRequest.payloadOffset;
   txPayloadBufferNextPtr = txPayloadBuffer;
+  responsePayloadSize    = 0;
+  responseOverflow       = false;
 
-  //TODO whatif groupIdx > number of groups?
+  const uint32_t startTime = micros();
+  const uint8_t  status    = executeInstruction(activeRequest.code, activeRequest.payloadSize);
+  statistics.recordInstruction(activeRequest.code, status == INSTRUCTION_STATUS_OK, micros() - startTime);
 
-  switch(requestCode) {
+  if (activeRequest.address == COMM_BROADCAST_ADDRESS) return; // Broadcast requests are never responded
 
-    // Global Instructions
-    case GET_PLC_LAST_CHANGE_ADDR:
-      writeResponsePayload(taskSchedulerThread->getLastChangeTimestamp());
-      break;
-    case GET_AUTO_VALUE_ADDR: //Get auto mode enable state
-      writeResponsePayload(taskSchedulerThread->getAutoModeState());
-      break;
-    case 0x3:
-      break;
-    case 0x4:
-      break;
-    case GET_CLOCK_ADDR: //Get clock
-      writeResponsePayload(taskSchedulerThread->getTime());
-      break;
-    case SET_CLOCK_ADDR: //Set clock
-      taskSchedulerThread->setTime(readRequestPayloadInt(4));
-
-      // Cancel all active jobs after clock change, as the finish timestamps will be corrupted
-      swimmingPoolController->stopJob();
-      electrovavlesThread->cancelAllJobs();
-      break;
-
-
-    // Swimming Pool Instructions
-    case SP_GET_LAST_CHANGE_ADDR: // Swimming Pool Controller last change timestamp
-      writeResponsePayload(swimmingPoolController->getLastChangeTimestamp());
-      break;
-    case SP_GET_CONTROLLER_STATE_ADDR: //Swimming Pool Controller State
-      writeResponsePayload(swimmingPoolController->getControllerState());
-	    break;
-    case SP_GET_PUMP_STATE_ADDR: //Recirculation pump state
-      writeResponsePayload(swimmingPoolController->swimmingPoolRecirculationPump->getState());
-      break;
-    case SP_GET_UV_STATE_ADDR: //UV state
-      writeResponsePayload(swimmingPoolController->uvDisinfectLight->getState());
-      break;
-    case SP_GET_PUMP_MANUAL_VALUE_ADDR: //Recirculation pump manual override input value
-      writeResponsePayload(swimmingPoolController->manualOverride->value());
-      break;
-    case SP_GET_UV_ENABLE_VALUE_ADDR: //UV enable input value
-      writeResponsePayload(swimmingPoolController->UVEnable->value());
-      break;
-    case SP_GET_FLOW_SENSOR_VALUE_ADDR: //Recirculation flow sensor input value
-      writeResponsePayload(swimmingPoolController->recirculationSensor->value());
-      break;
-    case SP_GET_PUMP_MANUAL_DISABLE_ADDR: //Recirculation pump manual override disable state
-      writeResponsePayload(swimmingPoolController->getRecirculationPumpManualOverrideLockState());
-      break;
-    case SP_GET_SCHEDULE_ENABLE_ADDR: //Get schedule enable state
-      writeResponsePayload(swimmingPoolController->isScheduleEnabled());
-      break;
-    case SP_SET_SCHEDULE_ENABLE_ADDR: //Set schedule enable state
-      if (readRequestPayloadInt(1) == 0) swimmingPoolController->disableSchedule();
-      else                        swimmingPoolController->enableSchedule();
-      break;
-    case SP_GET_SCHEDULE_NEXT_ADDR: //Get next scheduled turn on time
-      writeResponsePayload(swimmingPoolController->getNextTurnOnTime());
-      break;
-    case SP_SET_SCHEDULE_NEXT_ADDR: //Set next scheduled turn on time
-      swimmingPoolController->setNextTurnOnTime(readRequestPayloadInt(4));
-      break;
-    case SP_GET_SCHEDULE_DURATION_ADDR: //Get scheduled recirculation duration
-      writeResponsePayload(swimmingPoolController->getDuration());
-      break;
-    case SP_SET_SCHEDULE_DURATION_ADDR: //Set scheduled recirculation duration
-      swimmingPoolController->setDuration(readRequestPayloadInt(2));
-      break;
-    case SP_GET_SCHEDULE_PERIOD_ADDR: //Get scheduled period
-      writeResponsePayload(swimmingPoolController->getPeriodDays());
-      break;
-    case SP_SET_SCHEDULE_PERIOD_ADDR: //Set scheduled period
-      swimmingPoolController->setPeriodDays(readRequestPayloadInt(1));
-      break;
-    case SP_REQ_SCHEDULE_RESET_ADDR: //Reset
-      if (readRequestPayloadInt(2) == 0xAA00) swimmingPoolController->reset();
-      break;
-    
-
-    // Irrigation Instructions
-    case IRR_GET_LAST_CHANGE_ADDR:
-      writeResponsePayload(irrigationController->getLastChangeTimestamp());
-      break;
-    case IRR_GET_CONTROLLER_STATE_ADDR:
-      writeResponsePayload(irrigationController->getControllerState());
-      break;
-    case IRR_GET_PUMP_STATE_ADDR: //Irrigation pump state
-      writeResponsePayload(electrovavlesThread->swimmingPoolIrrigationPump->getState());
-      break;
-    case IRR_GET_MAINS_INLET_STATE_ADDR: //Mains water inlet state
-      writeResponsePayload(electrovavlesThread->mainsWaterInletValve->getState());
-      break;
-    case IRR_GET_MANUAL_VALUE_ADDR: //Irrigation from swimming pool manual override input value
-      writeResponsePayload(irrigationController->manualIrrigationEnable->value());
-      break;
-    case IRR_GET_PRESSURE_SENSOR_VALUE_ADDR: //Irrigation pressure sensor input value
-      writeResponsePayload(irrigationController->irrigationPressureSensor->value());
-      break;
-    case IRR_GET_MANUAL_DISABLE_STATE_ADDR: //Manual irrigation disable state
-      writeResponsePayload(irrigationController->getManualOverrideLockState());
-      break;
-    case IRR_GET_ZONES_STATE_ADDR: //Zones state
-      writeResponsePayload(irrigationController->getZonesState());
-      break;
-    case IRR_GET_MANUAL_ZONES_ADDR: //Get manual irrigation zones
-      writeResponsePayload(irrigationController->getIrrigationManualZones());
-      break;
-    case IRR_SET_MANUAL_ZONES_ADDR: //Set manual irrigation zones
-      irrigationController->setIrrigationManualZones(readRequestPayloadInt(2));
-      break;
-    case IRR_GET_MANUAL_SOURCE_ADDR: //Get manual irrigation source
-      writeResponsePayload(irrigationController->getIrrigationManualSource());
-      break;
-    case IRR_SET_MANUAL_SOURCE_ADDR: //Set manual irrigation source
-      irrigationController->setIrrigationManualSource(readRequestPayloadInt(1));
-      break;
-    case IRR_GET_SCHEDULE_ENABLE_ADDR: //Get irrigation enable state
-      writeResponsePayload(irrigationController->isScheduleEnabled());
-      break;
-    case IRR_SET_SCHEDULE_ENABLE_ADDR: //Set irrigation enable state
-      if (readRequestPayloadInt(1) == 0) irrigationController->disableSchedule();
-      else                        irrigationController->enableSchedule();
-      break;
-    case IRR_GET_SCHEDULE_PAUSED_STATE_ADDR: //Get irrigation paused state
-      writeResponsePayload(irrigationController->isSchedulePaused());
-      break;
-    case IRR_SET_SCHEDULE_PAUSE_TIMESTAMP_ADDR: //Pause irrigation
-      irrigationController->pauseSchedule(readRequestPayloadInt(4));
-      break;
-    case IRR_REQ_SCHEDULE_RESUME_ADDR: //Resume irrigation
-      if (readRequestPayloadInt(1) != 0) irrigationController->resumeSchedule();
-      break;
-    case IRR_GET_SCHEDULE_RESUME_TIME_ADDR: //Get irrigation scheduled resume time
-      writeResponsePayload(irrigationController->getScheduleResumeTime());
-      break;
-    case IRR_GET_NEXT_IRRIGATION_TIME_ADDR: //Get next irrigation time
-      writeResponsePayload(irrigationController->getNextIrrigationTime());
-      break;
-    case IRR_GET_SCHEDULE_GROUPS_STATE_ADDR: //Get irrigation groups enable state
-      writeResponsePayload(irrigationController->getGroupsEnableState());
-      break;
-    case IRR_GET_SCHEDULE_GROUP_STATE_ADDR: //Get irrigation group enable state
-      writeResponsePayload(irrigationController->isGroupEnabled(readRequestPayloadInt(1)));
-      break;
-    case IRR_SET_SCHEDULE_GROUP_STATE_ADDR: //Set irrigation group enable state
-      groupIdx = readRequestPayloadInt(1);
-      if (readRequestPayloadInt(1) == 0) irrigationController->disableGroup(groupIdx);
-      else                        irrigationController->enableGroup(groupIdx);
-      break;
-    case IRR_GET_SCHEDULE_GROUP_NAME_ADDR: //Get irrigation group name
-      irrigationController->getGroupName(readRequestPayloadInt(1), tempGroupNameBuff);
-      writeResponsePayload((uint8_t*) &tempGroupNameBuff, IRRIGATION_GROUP_NAME_LENGTH);
-      break;
-    case IRR_SET_SCHEDULE_GROUP_NAME_ADDR: //Set irrigation group name
-      groupIdx = readRequestPayloadInt(1);
-      readRequestPayload((uint8_t*) &tempGroupNameBuff, IRRIGATION_GROUP_NAME_LENGTH);
-      irrigationController->setGroupName(groupIdx, tempGroupNameBuff);
-      break;
-    case IRR_GET_SCHEDULE_GROUP_ZONES_ADDR: //Get irrigation group zones
-      writeResponsePayload(irrigationController->getGroupZones(readRequestPayloadInt(1)));
-      break;
-    case IRR_SET_SCHEDULE_GROUP_ZONES_ADDR: //Set irrigation group zones
-      groupIdx = readRequestPayloadInt(1);
-      irrigationController->setGroupZones(groupIdx, readRequestPayloadInt(2));
-      break;
-    case IRR_GET_SCHEDULE_GROUP_SOURCE_ADDR: //Get irrigation group source
-      writeResponsePayload(irrigationController->getGroupSource(readRequestPayloadInt(1)));
-      break;
-    case IRR_SET_SCHEDULE_GROUP_SOURCE_ADDR: //Set irrigation group source
-      groupIdx = readRequestPayloadInt(1);
-      irrigationController->setGroupSource(groupIdx, readRequestPayloadInt(1));
-      break;
-    case IRR_GET_SCHEDULE_GROUP_PERIOD_ADDR: //Get irrigation group period
-      writeResponsePayload(irrigationController->getGroupPeriod(readRequestPayloadInt(1)));
-      break;
-    case IRR_SET_SCHEDULE_GROUP_PERIOD_ADDR: //Set irrigation group period
-      groupIdx = readRequestPayloadInt(1);
-      irrigationController->setGroupPeriod(groupIdx, readRequestPayloadInt(1));
-      break;
-    case IRR_GET_SCHEDULE_GROUP_DURATION_ADDR: //Get irrigation group duration
-      writeResponsePayload(irrigationController->getGroupDuration(readRequestPayloadInt(1)));
-      break;
-    case IRR_SET_SCHEDULE_GROUP_DURATION_ADDR: //Set irrigation group duration
-      groupIdx = readRequestPayloadInt(1);
-      irrigationController->setGroupDuration(groupIdx, readRequestPayloadInt(2));
-      break;
-    case IRR_GET_SCHEDULE_GROUP_INIT_TIME_ADDR: //Get irrigation group init time
-      writeResponsePayload(irrigationController->getGroupInitTime(readRequestPayloadInt(1)));
-      break;
-    case IRR_SET_SCHEDULE_GROUP_INIT_TIME_ADDR: //Set irrigation group init time
-      groupIdx = readRequestPayloadInt(1);
-      irrigationController->setGroupInitTime(groupIdx, readRequestPayloadInt(2));
-      break;
-    case IRR_GET_SCHEDULE_GROUP_NEXT_TIME_ADDR: //Get irrigation group next init time
-      writeResponsePayload(irrigationController->getGroupNextIrrigationTime(readRequestPayloadInt(1)));
-      break;
-    case IRR_REQ_SCHEDULE_GROUP_NOW_ADDR:
-      irrigationController->scheduleGroupNow(readRequestPayloadInt(1));
-      break;
-    case IRR_REQ_CANCEL_CURRENT_JOB_ADDR:
-      if (readRequestPayloadInt(1) != 0) electrovavlesThread->cancelCurrentJob();
-      break;
-    case IRR_REQ_CANCEL_ALL_JOBS_ADDR:
-      if (readRequestPayloadInt(1) != 0) electrovavlesThread->cancelAllJobs();
-      break;
-    case IRR_REQ_SCHEDULE_GROUP_RESET_ADDR: //Reset irrigation group
-      groupIdx = readRequestPayloadInt(1);
-      if (readRequestPayloadInt(2) == 0xBB01) irrigationController->resetGroup(groupIdx);
-      break;
-    case IRR_REQ_SCHEDULE_RESET_ADDR: //Reset
-      if (readRequestPayloadInt(2) == 0xBA00) irrigationController->reset();
-      break;
-
-    default:
-      // Unknown instruction. Do not respond
+  if (status == INSTRUCTION_STATUS_OK) {
+    sendResponse(activeRequest.code);
+  }
+  else if (activeRequest.frameFormat == FrameFormat::CRC) { // Do not respond to invalid legacy requests
+    sendNak(getNakReason(status));
+  }
+}
+
+uint8_t CommunicationsThread::getNakReason(uint8_t instructionStatus) {
+  switch (instructionStatus) {
+    case INSTRUCTION_STATUS_UNKNOWN:    return NAK_REASON_UNKNOWN;
+    case INSTRUCTION_STATUS_MALFORMED:  return NAK_REASON_MALFORMED;
+    case INSTRUCTION_STATUS_NO_SPACE:   return NAK_REASON_NO_SPACE;
+    default:                            return NAK_REASON_REJECTED;
+  }
+}
+
+void CommunicationsThread::executeBatch() {
+  const uint8_t* requestEndPtr = rxPayloadBufferNextPtr + instructionPayloadSize;
+
+  // Each sub-instruction requires at least 2 bytes (instruction code + payload size)
+  while (requestEndPtr - rxPayloadBufferNextPtr >= 2) {
+    const uint8_t  subCode          = *(rxPayloadBufferNextPtr++);
+    const uint8_t  subPayloadSize   = *(rxPayloadBufferNextPtr++);
+    const uint8_t* subPayloadEndPtr = rxPayloadBufferNextPtr + subPayloadSize;
+
+    // Write the sub-instruction response header (the status and payload size are set once the instruction is executed)
+    if (txPayloadBufferSize - responsePayloadSize < 3) return;
+    writeResponsePayload(subCode);
+    uint8_t* statusPtr = txPayloadBufferNextPtr;
+    writeResponsePayload((uint8_t) INSTRUCTION_STATUS_OK);
+    uint8_t* subResponseSizePtr = txPayloadBufferNextPtr;
+    writeResponsePayload((uint8_t) 0);
+
+    if (subPayloadEndPtr > requestEndPtr) {
+      *statusPtr = INSTRUCTION_STATUS_MALFORMED;
+      return;
+    }
+
+    // Execute the sub-instruction (nested batches are not allowed)
+    uint8_t* subResponsePtr = txPayloadBufferNextPtr;
+    *statusPtr = subCode == BATCH_ADDR ? INSTRUCTION_STATUS_UNKNOWN : executeInstruction(subCode, subPayloadSize);
+
+    if (*statusPtr == INSTRUCTION_STATUS_NO_SPACE) {
+      // Discard the partially written response
+      responsePayloadSize   -= txPayloadBufferNextPtr - subResponsePtr;
+      txPayloadBufferNextPtr = subResponsePtr;
+      responseOverflow       = false;
       return;
+    }
 
+    *subResponseSizePtr    = txPayloadBufferNextPtr - subResponsePtr;
+    rxPayloadBufferNextPtr = (uint8_t*) subPayloadEndPtr;
   }
+}
+
+uint8_t CommunicationsThread::executeInstruction(uint8_t instructionCode, uint8_t payloadSize) {
+  InstructionDefinition instruction;
 
-  sendResponse();
+  if (!findInstruction(instructionCode, instruction)) return INSTRUCTION_STATUS_UNKNOWN;
 
+  // Validate the request payload size, and make sure the response will fit in the Tx buffer
+  if (
+    instruction.requestSize != INSTRUCTION_VARIABLE_SIZE &&
+    instruction.requestSize != payloadSize
+  ) return INSTRUCTION_STATUS_MALFORMED;
+
+  if (
+    instruction.responseSize != INSTRUCTION_VARIABLE_SIZE &&
+    instruction.responseSize > txPayloadBufferSize - responsePayloadSize
+  ) return INSTRUCTION_STATUS_NO_SPACE;
+
+  instructionPayloadSize = payloadSize;
+  instructionStatus      = INSTRUCTION_STATUS_OK;
+  instruction.handler(*this);
+
+  return responseOverflow ? INSTRUCTION_STATUS_NO_SPACE : instructionStatus;
 }
 
+void CommunicationsThread::executeIfChanged() {
+  if (instructionPayloadSize < 5) {
+    instructionStatus = INSTRUCTION_STATUS_MALFORMED;
+    return;
+  }
 
+  const uint32_t sinceVersion = readRequestPayloadInt(4);
+  const uint8_t  code         = readRequestPayloadInt(1);
+  const uint8_t  payloadSize  = instructionPayloadSize - 5;
 
-void CommunicationsThread::sendResponse() {
-  //TODO make sure responsePayloadSize is no larger than the buffer size
+  // Only plain read instructions can be executed conditionally (no batches, nested conditionals or writes)
+  InstructionDefinition instruction;
+  if (!findInstruction(code, instruction)) {
+    instructionStatus = INSTRUCTION_STATUS_UNKNOWN;
+    return;
+  }
 
-  txPayloadBufferNextPtr = txPayloadBuffer; // Reset the Tx buffer read pointer to the start of the buffer
+  if (instruction.flags != INSTRUCTION_READ || code == GET_IF_CHANGED_ADDR) {
+    instructionStatus = INSTRUCTION_STATUS_REJECTED;
+    return;
+  }
 
-  max485->beginTransmission();
+  if (!hasInstructionChangedSince(code, payloadSize, sinceVersion)) {
+    writeResponsePayload((uint8_t) IF_CHANGED_NOT_MODIFIED);
+    return;
+  }
+
+  // The version is read before the value, so that a change made afterwards is never missed by the client
+  writeResponsePayload((uint8_t) IF_CHANGED_MODIFIED);
+  writeResponsePayload(changeTracker->getVersion());
+
+  instructionStatus = executeInstruction(code, payloadSize);
+}
+
+bool CommunicationsThread::hasInstructionChangedSince(uint8_t instructionCode, uint8_t payloadSize, uint32_t sinceVersion) {
+  switch (instructionCode) {
+    case GET_PLC_LAST_CHANGE_ADDR:
+    case GET_PLC_SNAPSHOT_ADDR:
+    case SP_GET_LAST_CHANGE_ADDR:
+    case IRR_GET_LAST_CHANGE_ADDR:
+      // Any tracked change (or another session)
+      return sinceVersion != changeTracker->getVersion();
+
+    case IRR_GET_SCHEDULE_GROUP_STATE_ADDR:
+    case IRR_GET_SCHEDULE_GROUP_NAME_ADDR:
+    case IRR_GET_SCHEDULE_GROUP_ZONES_ADDR:
+    case IRR_GET_SCHEDULE_GROUP_SOURCE_ADDR:
+    case IRR_GET_SCHEDULE_GROUP_PERIOD_ADDR:
+    case IRR_GET_SCHEDULE_GROUP_DURATION_ADDR:
+    case IRR_GET_SCHEDULE_GROUP_INIT_TIME_ADDR:
+    case IRR_GET_SCHEDULE_GROUP_NEXT_TIME_ADDR:
+    case IRR_GET_SCHEDULE_GROUPS_ADDR: {
+      // Invalid requests are executed, so that the client gets the same response as for the unconditional instruction
+      if (payloadSize < 1 || rxPayloadBufferNextPtr[0] >= IRRIGATION_GROUPS_COUNT) return true;
+
+      const uint8_t firstGroupIdx = rxPayloadBufferNextPtr[0];
+      const uint8_t groupsCount   = instructionCode == IRR_GET_SCHEDULE_GROUPS_ADDR && payloadSize >= 2 ? rxPayloadBufferNextPtr[1] : 1;
+
+      for (uint8_t i = firstGroupIdx; i < IRRIGATION_GROUPS_COUNT && i - firstGroupIdx < groupsCount; i++) {
+        if (changeTracker->hasChangedSince(CHANGE_FIELD_IRR_GROUP_0 + i, sinceVersion)) return true;
+      }
+      return false;
+    }
+  }
+
+  for (uint8_t field = 0; field < CHANGE_FIELD_IRR_GROUP_0; field++) {
+    if (pgm_read_byte(&changeFieldInstructions[field]) == instructionCode) {
+      return changeTracker->hasChangedSince(field, sinceVersion);
+    }
+  }
+
+  return true; // Not tracked
+}
 
-  max485->write(requestCode);
-  max485->write(responsePayloadSize | ((checkResponseParity() ? 0 : 1) << 7)); // Parity bit - make the number of 1s in the response even 
 
-  for (int8_t i = 0; i < responsePayloadSize; i++) {
-    max485->write(*(txPayloadBufferNextPtr++));
+
+void CommunicationsThread::sendResponse(uint8_t responseCode) {
+  // Build the frame header and trailer around the Tx payload buffer. The frame is then sent by 'transmitResponse' as
+  // space becomes available in the serial Tx buffer, so that the response does not block the other threads
+  responseFrameHeaderSize  = 0;
+  responseFrameTrailerSize = 0;
+  responseFramePayloadSize = responsePayloadSize;
+  responseFrameSent        = 0;
+
+  if (activeRequest.frameFormat == FrameFormat::CRC) {
+    uint16_t crc = crc16Update(CRC16_INITIAL_VALUE, PLC_NODE_ADDRESS);
+    if (activeRequest.hasSequence) crc = crc16Update(crc, activeRequest.sequence);
+    crc = crc16Update(crc, responseCode);
+    crc = crc16Update(crc, responsePayloadSize);
+    crc = crc16(txPayloadBuffer, responsePayloadSize, crc);
+
+    responseFrameHeader[responseFrameHeaderSize++] = activeRequest.hasSequence ? FRAME_SEQ_START_MARKER : FRAME_START_MARKER;
+    responseFrameHeader[responseFrameHeaderSize++] = PLC_NODE_ADDRESS;
+    if (activeRequest.hasSequence) responseFrameHeader[responseFrameHeaderSize++] = activeRequest.sequence;
+    responseFrameHeader[responseFrameHeaderSize++] = responseCode;
+    responseFrameHeader[responseFrameHeaderSize++] = responsePayloadSize;
+
+    responseFrameTrailer[responseFrameTrailerSize++] = (uint8_t) (crc >> 8);
+    responseFrameTrailer[responseFrameTrailerSize++] = (uint8_t) crc;
+  }
+  else {
+    responseFrameHeader[responseFrameHeaderSize++] = responseCode;
+    responseFrameHeader[responseFrameHeaderSize++] = responsePayloadSize | ((checkResponseParity(responseCode) ? 0 : 1) << 7); // Parity bit - make the number of 1s in the response even 
   }
 
   // Serial.available() treats 0xFF as EOL and will skip it if it's the last byte on the buffer.
   // Always transmit 0x0 at the end of the response as a workaround
-  max485->write(0x0);
+  responseFrameTrailer[responseFrameTrailerSize++] = 0x0;
+
+  max485->beginTransmission();
+  responseState = ResponseState::SENDING;
+
+  transmitResponse();
+}
+
+void CommunicationsThread::transmitResponse() {
+  if (responseState == ResponseState::SENDING) {
+    const uint16_t frameSize = responseFrameHeaderSize + responseFramePayloadSize + responseFrameTrailerSize;
+
+    // Only write as many bytes as fit in the serial Tx buffer, so that the write calls never block
+    int availableForWrite = COMM_SERIAL.availableForWrite();
+    while (availableForWrite-- > 0 && responseFrameSent < frameSize) {
+      max485->write(getResponseFrameByte(responseFrameSent++));
+      statistics.recordByteSent();
+    }
+
+    if (responseFrameSent < frameSize) return;
+
+    responseState = ResponseState::DRAINING;
+  }
+
+  // Release the bus once the last byte has left the UART shift register
+#if defined(UCSR0A) && defined(TXC0)
+  // The transmit complete flag is cleared by HardwareSerial on every write (COMM_SERIAL is expected to be USART0)
+  if (!(UCSR0A & _BV(TXC0))) return;
+#else
+  // Wait for the serial Tx buffer to be empty, 'endTransmission' then waits for the last byte to be shifted out
+  if (COMM_SERIAL.availableForWrite() < SERIAL_TX_BUFFER_SIZE - 1) return;
+#endif
 
   max485->endTransmission();
+  responseState = ResponseState::IDLE;
+}
+
+uint8_t CommunicationsThread::getResponseFrameByte(uint16_t index) {
+  if (index < responseFrameHeaderSize) return responseFrameHeader[index];
+  index -= responseFrameHeaderSize;
+
+  if (index < responseFramePayloadSize) return txPayloadBuffer[index];
+  index -= responseFramePayloadSize;
+
+  return responseFrameTrailer[index];
+}
+
+void CommunicationsThread::sendNak(uint8_t reason) {
+  txPayloadBuffer[0]  = activeRequest.code;
+  txPayloadBuffer[1]  = reason;
+  responsePayloadSize = 2;
+
+  sendResponse(FRAME_NAK_CODE);
+}
+
+
+
+void CommunicationsThread::getSnapshot(PLCSnapshot& snapshot) {
+  snapshot.version = PLC_SNAPSHOT_VERSION;
+
+  // Global
+  snapshot.time                = taskSchedulerThread->getTime();
+  snapshot.lastChangeTimestamp = taskSchedulerThread->getLastChangeTimestamp();
+  snapshot.flags               = taskSchedulerThread->getAutoModeState() << SNAPSHOT_AUTO_MODE_BIT;
+
+  // Swimming Pool
+  snapshot.spLastChangeTimestamp = swimmingPoolController->getLastChangeTimestamp();
+  snapshot.spControllerState     = swimmingPoolController->getControllerState();
+  snapshot.spFlags               =
+    (swimmingPoolController->swimmingPoolRecirculationPump->getState()        << SNAPSHOT_SP_PUMP_STATE_BIT)          |
+    (swimmingPoolController->uvDisinfectLight->getState()                     << SNAPSHOT_SP_UV_STATE_BIT)            |
+    (swimmingPoolController->manualOverride->value()                          << SNAPSHOT_SP_PUMP_MANUAL_VALUE_BIT)   |
+    (swimmingPoolController->UVEnable->value()                                << SNAPSHOT_SP_UV_ENABLE_VALUE_BIT)     |
+    (swimmingPoolController->recirculationSensor->value()                     << SNAPSHOT_SP_FLOW_SENSOR_VALUE_BIT)   |
+    (swimmingPoolController->getRecirculationPumpManualOverrideLockState()    << SNAPSHOT_SP_PUMP_MANUAL_DISABLE_BIT) |
+    (swimmingPoolController->isScheduleEnabled()                              << SNAPSHOT_SP_SCHEDULE_ENABLE_BIT);
+  snapshot.spScheduleNextTime    = swimmingPoolController->getNextTurnOnTime();
+  snapshot.spScheduleDuration    = swimmingPoolController->getDuration();
+  snapshot.spSchedulePeriod      = swimmingPoolController->getPeriodDays();
+
+  // Irrigation
+  snapshot.irrLastChangeTimestamp = irrigationController->getLastChangeTimestamp();
+  snapshot.irrControllerState     = irrigationController->getControllerState();
+  snapshot.irrFlags               =
+    (electrovavlesThread->swimmingPoolIrrigationPump->getState()  << SNAPSHOT_IRR_PUMP_STATE_BIT)            |
+    (electrovavlesThread->mainsWaterInletValve->getState()        << SNAPSHOT_IRR_MAINS_INLET_STATE_BIT)     |
+    (irrigationController->manualIrrigationEnable->value()        << SNAPSHOT_IRR_MANUAL_VALUE_BIT)          |
+    (irrigationController->irrigationPressureSensor->value()      << SNAPSHOT_IRR_PRESSURE_SENSOR_VALUE_BIT) |
+    (irrigationController->getManualOverrideLockState()           << SNAPSHOT_IRR_MANUAL_DISABLE_BIT)        |
+    (irrigationController->isScheduleEnabled()                    << SNAPSHOT_IRR_SCHEDULE_ENABLE_BIT)       |
+    (irrigationController->isSchedulePaused()                     << SNAPSHOT_IRR_SCHEDULE_PAUSED_BIT);
+  snapshot.irrZonesState          = irrigationController->getZonesState();
+  snapshot.irrManualZones         = irrigationController->getIrrigationManualZones();
+  snapshot.irrManualSource        = irrigationController->getIrrigationManualSource();
+  snapshot.irrScheduleResumeTime  = irrigationController->getScheduleResumeTime();
+  snapshot.irrNextIrrigationTime  = irrigationController->getNextIrrigationTime();
+  snapshot.irrGroupsState         = irrigationController->getGroupsEnableState();
+}
+
+
+void CommunicationsThread::writeChangesSince(uint32_t sinceVersion, uint8_t firstField) {
+  writeResponsePayload(changeTracker->getVersion());
+  uint8_t* nextFieldPtr = txPayloadBufferNextPtr;
+  writeResponsePayload((uint8_t) CHANGES_SINCE_COMPLETE);
+
+  for (uint8_t field = firstField; field < CHANGE_FIELDS_COUNT; field++) {
+    if (!changeTracker->hasChangedSince(field, sinceVersion)) continue;
+
+    uint8_t* fieldPtr = txPayloadBufferNextPtr;
+    writeResponsePayload(field);
+    uint8_t* valueSizePtr = txPayloadBufferNextPtr;
+    writeResponsePayload((uint8_t) 0);
+
+    uint8_t* valuePtr = txPayloadBufferNextPtr;
+
+    if (writeFieldValue(field) == INSTRUCTION_STATUS_NO_SPACE) {
+      // Discard the partially written field, and let the client know where to continue from
+      responsePayloadSize   -= txPayloadBufferNextPtr - fieldPtr;
+      txPayloadBufferNextPtr = fieldPtr;
+      responseOverflow       = false;
+      *nextFieldPtr          = field;
+      return;
+    }
+
+    *valueSizePtr = txPayloadBufferNextPtr - valuePtr;
+  }
+}
+
+uint8_t CommunicationsThread::writeFieldValue(uint8_t field) {
+  if (field >= CHANGE_FIELD_IRR_GROUP_0) {
+    IrrigationGroup irrGroup;
+    irrigationController->getGroup(field - CHANGE_FIELD_IRR_GROUP_0, irrGroup);
+    writeResponsePayload((uint8_t*) &irrGroup, sizeof(IrrigationGroup));
+    return responseOverflow ? INSTRUCTION_STATUS_NO_SPACE : INSTRUCTION_STATUS_OK;
+  }
+
+  return executeInstruction(pgm_read_byte(&changeFieldInstructions[field]), 0);
+}
+
+void CommunicationsThread::writeScheduleGroups(uint8_t firstGroupIdx, uint8_t groupsCount) {
+  // Limit the groups count to the existing groups and to the space left in the Tx buffer
+  const uint8_t availableGroups = firstGroupIdx < IRRIGATION_GROUPS_COUNT ? IRRIGATION_GROUPS_COUNT - firstGroupIdx : 0;
+  const uint8_t fittingGroups   = (txPayloadBufferSize - responsePayloadSize - 2) / sizeof(IrrigationGroup);
+
+  groupsCount = min(groupsCount, min(availableGroups, fittingGroups));
+
+  writeResponsePayload(firstGroupIdx);
+  writeResponsePayload(groupsCount);
+
+  IrrigationGroup irrGroup;
+  for (uint8_t i = 0; i < groupsCount; i++) {
+    irrigationController->getGroup(firstGroupIdx + i, irrGroup);
+    writeResponsePayload((uint8_t*) &irrGroup, sizeof(IrrigationGroup));
+  }
+}
+
+void CommunicationsThread::writeInstructionStatistics(uint8_t firstSlotIdx) {
+  // Limit the slots count to the tracked instructions and to the space left in the Tx buffer
+  const uint8_t trackedSlots = statistics.getInstructionsCount();
+  const uint8_t fittingSlots = (txPayloadBufferSize - responsePayloadSize - 2) / sizeof(InstructionStatistics);
+  
+  const uint8_t slotsCount = min(firstSlotIdx < trackedSlots ? trackedSlots - firstSlotIdx : 0, fittingSlots);
+
+  writeResponsePayload(firstSlotIdx);
+  writeResponsePayload(slotsCount);
+
+  for (uint8_t i = 0; i < slotsCount; i++) {
+    writeResponsePayload((uint8_t*) &statistics.getInstruction(firstSlotIdx + i), sizeof(InstructionStatistics));
+  }
+}
+
+void CommunicationsThread::writeThreadStatistics(uint8_t firstSlotIdx) {
+  // Limit the slots count to the tracked threads and to the space left in the Tx buffer
+  const uint8_t trackedSlots = threadController->getStatisticsCount();
+  const uint8_t fittingSlots = (txPayloadBufferSize - responsePayloadSize - 2) / sizeof(ThreadStatistics);
+
+  const uint8_t slotsCount = min(firstSlotIdx < trackedSlots ? trackedSlots - firstSlotIdx : 0, fittingSlots);
+
+  writeResponsePayload(firstSlotIdx);
+  writeResponsePayload(slotsCount);
+
+  for (uint8_t i = 0; i < slotsCount; i++) {
+    writeResponsePayload((uint8_t*) &threadController->getStatistics(firstSlotIdx + i), sizeof(ThreadStatistics));
+  }
+}
+
+void CommunicationsThread::writeConfigImage(uint16_t offset) {
+  writeResponsePayload((uint16_t) CONFIG_IMAGE_SIZE);
+
+  // Read the image straight into the Tx buffer, as much as fits
+  const uint8_t bytesCount = offset < CONFIG_IMAGE_SIZE ? min(CONFIG_IMAGE_SIZE - offset, txPayloadBufferSize - responsePayloadSize) : 0;
+  dataSaver->readConfigImage(offset, txPayloadBufferNextPtr, bytesCount);
+
+  txPayloadBufferNextPtr += bytesCount;
+  responsePayloadSize    += bytesCount;
 }
 
 
@@ -355,7 +730,6 @@ uint32_t CommunicationsThread::readRequestPayloadInt(uint8_t bytesCount) {
   uint32_t response = 0;
 
   uint8_t* responsePtr = (uint8_t*) &response;
-  uint8_t packet;
 
   for (int8_t i = 0; i < bytesCount; i++) {
     responsePtr[i] = *(rxPayloadBufferNextPtr++);
@@ -389,8 +763,13 @@ void CommunicationsThread::writeResponsePayload(uint32_t response) {
 }
 
 void CommunicationsThread::writeResponsePayload(uint8_t* responsePtr, uint8_t bytesCount) {
+  if (bytesCount > txPayloadBufferSize - responsePayloadSize) {
+    responseOverflow = true;
+    return;
+  }
+
   responsePayloadSize += bytesCount;
-  for (int8_t i = 0; i < bytesCount; i++) {
+  for (uint8_t i = 0; i < bytesCount; i++) {
     *txPayloadBufferNextPtr++ = responsePtr[i];
   }
 }
@@ -399,16 +778,8 @@ void CommunicationsThread::writeResponsePayload(uint8_t* responsePtr, uint8_t by
 
 // Parity check functions *******************************************************************************************************
 
-bool CommunicationsThread::checkRequestParity() {
-  bool parity = checkParity(&requestCode);
-  parity = parity == checkParity(&requestPayloadSize);
-  parity = parity == checkParity(rxPayloadBuffer, requestPayloadSize);
-
-  return parity;
-}
-
-bool CommunicationsThread::checkResponseParity() {
-  bool parity = checkParity(&requestCode);
+bool CommunicationsThread::checkResponseParity(uint8_t responseCode) {
+  bool parity = checkParity(&responseCode);
   parity = parity == checkParity(&responsePayloadSize);
   parity = parity == checkParity(txPayloadBuffer, responsePayloadSize);
 
@@ -428,4 +799,4 @@ bool CommunicationsThread::checkParity(uint8_t* startPtr, uint8_t size) {
     parity = parity == checkParity(startPtr + i);
   }
   return parity; // 'True' if the number of 1s is even
-}
\ No newline at end of file
+}
@@ -5,19 +5,138 @@
   via the MAX485 component.
 
   A custom communication protocol is implemented, each transmission is formed as:
+    1 Byte  - Start of Frame Marker (FRAME_START_MARKER)
+    1 Byte  - Node Address
     1 Byte  - Instruction Code
-    2 Bytes - Parity Bit + Payload Size (First bit (MSB) is the parity bit)
+    1 Byte  - Payload Size
     N Bytes - Payload
+    2 Bytes - CRC-16 (see Crc16.h) of the node address, instruction code, payload size and payload (most significant
+              byte first)
     NULL character
+
+  If the frame starts with FRAME_SEQ_START_MARKER, an extra sequence number byte follows the node address (and is
+  covered by the CRC). The sequence number is echoed in the response, which also starts with FRAME_SEQ_START_MARKER,
+  so that the client can match the responses with their requests.
+
+  Multiple nodes can share the RS485 bus: each node only handles the requests addressed to its PLC_NODE_ADDRESS, and 
+  responds with its own address. Requests addressed to COMM_BROADCAST_ADDRESS are handled by every node but never
+  responded, and are restricted to the instructions flagged as INSTRUCTION_BROADCAST (see InstructionTable.h).
+
+  Bytes received outside of a frame are discarded until the next start of frame marker is found, which allows the
+  receiver to resynchronise mid-stream after a corrupted or incomplete frame. If a request addressed to the node fails
+  the CRC check, does not end with the NULL character, is too large, has an unknown instruction code, or fails to be
+  executed, a NAK frame (FRAME_NAK_CODE) is sent back whose payload is formed by the request instruction code and the
+  NAK reason (NAK_REASON_*, which matches the INSTRUCTION_STATUS_* of the failed instructions).
+
+  If COMM_LEGACY_FRAMING_ENABLED is set, the legacy frames (used by older clients) are also accepted, each formed as:
+    1 Byte  - Instruction Code
+    1 Byte  - Parity Bit + Payload Size (First bit (MSB) is the parity bit)
+    N Bytes - Payload
+    NULL character
+  Legacy requests are responded with a legacy frame, and are silently dropped on error.
+  Legacy support is disabled by default and should only be enabled for clients that cannot send CRC frames: as any byte
+  received outside of a frame may start a legacy frame, the remainder of a corrupted/timed out CRC frame can be parsed as
+  legacy requests, which are only protected by the parity bit (i.e. about half of them would be executed). This defeats
+  the resynchronisation of the CRC framing.
   
-  When a request is received, once the parity check is successful, the request payload is written to the
-  Rx payload buffer. 
+  Requests are parsed byte by byte as they are received: the payload is written to the Rx payload buffer and the 
+  CRC/parity is computed on the fly. A request is abandoned if the time between two of its bytes exceeds
+  TIMEOUT_PER_PACKET. Requests with an unknown instruction code or an unexpected payload size (see InstructionTable.h)
+  are rejected as soon as their header is received: the rest of the frame is skipped without being stored.
+  Once the trailing NULL character is received, the request (or its rejection) is added to the request queue, so that
+  a client can send up to COMM_RX_QUEUE_LENGTH requests back to back without waiting for the responses. The payloads 
+  of the queued requests are stored sequentially in the Rx payload buffer: requests that do not fit in the free space 
+  left are rejected with NAK_REASON_BUSY. The queued requests are handled in order once the bus has been idle for 
+  COMM_RESPONSE_DELAY.
   The 'readRequestPayload' functions are then used to read data sequentially from this buffer; each call
   increments the 'rxPayloadBufferNextPtr'.
   Response data is written to the Tx payload buffer in a similar manner, using the 'writeResponsePayload' 
   functions and the 'txPayloadBufferNextPtr'.
-  Last, the response is sent using the protocol defined above. A response is always sent, even if there 
+  Last, the response is sent using the frame format of the request. A response is always sent, even if there 
   is no response payload.
+  Responses are sent without blocking: the frame is written to the serial Tx buffer as space becomes available on
+  each run of the thread, and the MAX485 transmit enable pin is released once the last byte has been shifted out.
+  No new requests are parsed whilst a response is being sent.
+
+  Multiple instructions can be sent within a single request using the BATCH_ADDR instruction code. The batch request
+  payload is formed by the concatenation of the sub-instructions, each formed as:
+    1 Byte  - Instruction Code
+    1 Byte  - Payload Size
+    N Bytes - Payload
+  The sub-instructions are executed in order, and the batch response payload is formed by the concatenation of the
+  sub-instructions responses, each formed as:
+    1 Byte  - Instruction Code
+    1 Byte  - Status (INSTRUCTION_STATUS_*)
+    1 Byte  - Payload Size
+    N Bytes - Payload
+  If the response of a sub-instruction does not fit in the Tx payload buffer, its status is set to 
+  INSTRUCTION_STATUS_NO_SPACE and the remaining sub-instructions are not executed.
+
+  The fields that have changed since a given change version (see ChangeTracker.h) can be retrieved using the 
+  GET_CHANGES_SINCE_ADDR instruction, whose request payload is formed as:
+    4 Bytes - Change version last seen by the client
+    1 Byte  - First field to check (ChangeField, 0 to check every field)
+  And whose response payload is formed as:
+    4 Bytes - Current change version
+    1 Byte  - Next field to check if not all changed fields fit in the response (CHANGES_SINCE_COMPLETE otherwise)
+    N x TLV - Changed fields, each formed as:
+                1 Byte  - Field (ChangeField)
+                1 Byte  - Value Size
+                N Bytes - Value (same as the value returned by the corresponding GET instruction; the whole 
+                          IrrigationGroup struct for the irrigation group fields)
+  If the response is incomplete, the client should repeat the request with the same version and the returned next 
+  field, and use the version of the first response for the next query.
+
+  A GET instruction can be executed conditionally using the GET_IF_CHANGED_ADDR instruction, whose request payload is 
+  formed as:
+    4 Bytes - Change version last seen by the client
+    1 Byte  - Instruction Code (read-only instructions only)
+    N Bytes - Instruction Payload
+  If the value returned by the instruction has not changed since the given version, the response payload is the single
+  byte IF_CHANGED_NOT_MODIFIED, and the instruction is not executed. Otherwise the response payload is formed as:
+    1 Byte  - IF_CHANGED_MODIFIED
+    4 Bytes - Current change version
+    N Bytes - Instruction Response
+  The values are matched to the ChangeTracker fields: the irrigation group instructions check the field of the requested
+  group(s), and the last change/snapshot instructions check every field (the clock is not considered). Instructions 
+  that are not tracked (e.g. the clock or the statistics) are always executed. Conditional instructions can be batched.
+
+  Whole irrigation groups are read with the IRR_GET_SCHEDULE_GROUPS_ADDR instruction, whose request payload is formed as:
+    1 Byte  - First group index
+    1 Byte  - Groups count
+  And whose response payload is formed as:
+    1 Byte  - First group index
+    1 Byte  - Returned groups count (limited by the groups count and the Tx payload buffer size)
+    N x IrrigationGroup structs
+  The client should repeat the request from the next group index if fewer groups than requested are returned.
+  A whole irrigation group is written with the IRR_SET_SCHEDULE_GROUP_ADDR instruction, whose request payload is formed
+  by the group index followed by the IrrigationGroup struct (its next irrigation time is ignored and recomputed). The 
+  group is validated and saved at once, and the response payload is a single byte set to 1 if the group was accepted.
+
+  The communication statistics (see CommunicationStatistics.h) are read with the GET_COMM_LINK_STATS_ADDR instruction
+  (link counters) and the GET_COMM_INSTRUCTION_STATS_ADDR instruction, whose request payload is the first statistics 
+  slot index, and whose response payload is formed as:
+    1 Byte  - First slot index
+    1 Byte  - Returned slots count (limited by the tracked instructions and the Tx payload buffer size)
+    N x InstructionStatistics structs
+
+  The persisted configuration can be backed up and restored as a single configuration image (see DataSaver.h). The
+  image is read with the GET_CONFIG_IMAGE_ADDR instruction, whose request payload is the image offset (2 Bytes), and
+  whose response payload is formed as:
+    2 Bytes - Image size
+    N Bytes - Image data from the requested offset (as many bytes as fit in the Tx payload buffer)
+  An image is imported by sending it in chunks with the STAGE_CONFIG_IMAGE_ADDR instruction, whose request payload is 
+  formed by the image offset (2 Bytes) followed by the chunk data, and then sending the COMMIT_CONFIG_IMAGE_ADDR 
+  instruction. Both respond with a single byte set to 1 on success. The commit validates the staged image header and 
+  CRC-16, copies it over the configuration and reloads the controllers (active jobs are cancelled). The EEPROM writes
+  block the PLC (up to ~3.3 ms per modified byte), so the client should allow for long response times.
+
+  The loop timing statistics (see TimedThreadController.h) are read with the GET_THREAD_STATS_ADDR instruction, whose
+  request payload is the first statistics slot index (slot 0 is the whole loop pass, followed by the threads), and 
+  whose response payload is formed as:
+    1 Byte  - First slot index
+    1 Byte  - Returned slots count (limited by the tracked threads and the Tx payload buffer size)
+    N x ThreadStatistics structs
 */
 
 #ifndef CommunicationsThread_h
@@ -28,46 +147,147 @@
 #include <MAX485.h>
 
 #include "../ControllerConfig.h"
+#include "../Utils/ChangeTracker.h"
+#include "../Utils/DataSaver.h"
+#include "CommunicationsTypes.h"
+#include "CommunicationStatistics.h"
+#include "../Utils/Crc16.h"
 #include "../TaskScheduler/TaskSchedulerThread.h"
+#include "../TaskScheduler/TimedThreadController.h"
 #include "../Irrigation/IrrigationController.h"
 #include "../SwimmingPool/SwimmingPoolController.h"
 
-const uint8_t payloadBufferSize = IRRIGATION_GROUP_NAME_LENGTH + 1; // Set to the largest possible request payload
+// Set to the largest payload that can be encoded in the payload size field, so that batch requests/responses can
+// hold as many sub-instructions as possible
+const uint8_t rxPayloadBufferSize = 0x7F;
+const uint8_t txPayloadBufferSize = 0x7F;
+
+static_assert(rxPayloadBufferSize >= sizeof(IrrigationGroup) + 1,     "The Rx buffer must fit the largest instruction request");
+static_assert(txPayloadBufferSize >= sizeof(PLCSnapshot),             "The Tx buffer must fit the largest instruction response");
+static_assert(txPayloadBufferSize >= sizeof(IrrigationGroup) + 2,     "The Tx buffer must fit at least one irrigation group");
+
+enum class FrameFormat : uint8_t {
+  CRC = 0,
+  LEGACY
+};
+
+enum class RequestState : uint8_t {
+  IDLE = 0,         // Waiting for the start of a frame
+  ADDRESS,          // Waiting for the node address (CRC frames)
+  SEQUENCE,         // Waiting for the sequence number (sequenced CRC frames)
+  CODE,             // Waiting for the instruction code (CRC frames)
+  SIZE,             // Waiting for the payload size (and parity bit for legacy frames)
+  PAYLOAD,          // Receiving the payload
+  CRC_HIGH,         // Waiting for the CRC most significant byte (CRC frames)
+  CRC_LOW,          // Waiting for the CRC least significant byte (CRC frames)
+  TERMINATOR,       // Waiting for the trailing NULL character
+  DISCARD           // Skipping the rest of a rejected request
+};
+
+enum class ResponseState : uint8_t {
+  IDLE = 0,         // No response pending
+  SENDING,          // Writing the response frame to the serial Tx buffer
+  DRAINING          // Waiting for the last byte to be transmitted to release the bus
+};
+
+struct ReceivedRequest {
+  FrameFormat frameFormat;
+  bool        hasSequence;
+  uint8_t     sequence;
+  uint8_t     address;
+  uint8_t     code;
+  uint8_t     payloadSize;
+  uint8_t     payloadOffset;    // Offset of the payload in the Rx payload buffer
+  uint8_t     nakReason;        // NAK_REASON_* if the request has been rejected, 0 otherwise
+};
 
 class CommunicationsThread: public Thread
 {
+  friend struct InstructionHandlers;
+
   public:
     CommunicationsThread(
       ElectrovalvesControlThread*& electrovavlesThread,
-      TaskSchedulerThread<2>*&     taskSchedulerThread,
+      TaskSchedulerThread*&        taskSchedulerThread,
+      TimedThreadController*&      threadController,
       IrrigationController*&       irrigationController,
-      SwimmingPoolController*&     swimmingPoolController
+      SwimmingPoolController*&     swimmingPoolController,
+      DataSaver*&                  dataSaver,
+      ChangeTracker*&              changeTracker
     );
     void run();
   
   private:
     ElectrovalvesControlThread*& electrovavlesThread;
-    TaskSchedulerThread<2>*&     taskSchedulerThread;
+    TaskSchedulerThread*&        taskSchedulerThread;
+    TimedThreadController*&      threadController;
     IrrigationController*&       irrigationController;
     SwimmingPoolController*&     swimmingPoolController;
+    DataSaver*&                  dataSaver;
+    ChangeTracker*&              changeTracker;
 
     MAX485* max485;
 
-    uint8_t  rxPayloadBuffer[payloadBufferSize] = {0};
-    uint8_t  txPayloadBuffer[payloadBufferSize] = {0};
+    uint8_t  rxPayloadBuffer[rxPayloadBufferSize] = {0};
+    uint8_t  txPayloadBuffer[txPayloadBufferSize] = {0};
     uint8_t* rxPayloadBufferNextPtr = rxPayloadBuffer;
     uint8_t* txPayloadBufferNextPtr = txPayloadBuffer;
 
-    uint32_t requestTimestamp   = 0;
-    uint8_t  requestCode        = 0;
-    bool     requestParityBit = false;
-    uint8_t  requestPayloadSize = 0;
-    uint32_t requestDataTimeout = 0;
+    RequestState    requestState           = RequestState::IDLE;
+    ReceivedRequest receivedRequest        = {};   // Request being received
+    uint32_t        requestTimestamp       = 0;    // Time at which the last byte was received
+    bool            requestParityBit       = false;
+    uint8_t         requestParity          = 0;    // XOR of the received bytes (legacy frames)
+    uint16_t        requestCrc             = CRC16_INITIAL_VALUE;
+    uint16_t        requestReceivedCrc     = 0;
+    uint16_t        requestPayloadReceived = 0;    // Also counts the skipped trailer bytes of a rejected request
+
+    ReceivedRequest requestQueue[COMM_RX_QUEUE_LENGTH] = {};
+    uint8_t         requestQueueHead       = 0;
+    uint8_t         requestQueueCount      = 0;
+    uint8_t         rxPayloadBufferUsed    = 0;    // Rx payload buffer bytes used by the queued requests
+    ReceivedRequest activeRequest          = {};   // Request being handled
+
+    CommunicationStatistics statistics;
 
     uint8_t  responsePayloadSize = 0;
+    bool     responseOverflow    = false;   // Set if a response write did not fit in the Tx buffer
+
+    ResponseState responseState            = ResponseState::IDLE;
+    uint8_t       responseFrameHeader[5]   = {0};  // Start of frame marker, node address, sequence, instruction code, payload size
+    uint8_t       responseFrameTrailer[3]  = {0};  // CRC, NULL character
+    uint8_t       responseFrameHeaderSize  = 0;
+    uint8_t       responseFrameTrailerSize = 0;
+    uint8_t       responseFramePayloadSize = 0;
+    uint16_t      responseFrameSent        = 0;    // Bytes of the response frame written to the serial Tx buffer
+
+    uint8_t  instructionPayloadSize = 0;    // Request payload size of the instruction being executed
+    uint8_t  instructionStatus      = 0;    // May be set by the handler to reject the request (INSTRUCTION_STATUS_*)
+
+    void receiveByte(const uint8_t byte);
+    bool validateRequestHeader();           // Returns false (and sets the NAK reason) if the request must be skipped
+    void queueReceivedRequest();
+    void resetRequest();
+
+    void handleNextRequest();
+    void handleRequest();
+    uint8_t executeInstruction(uint8_t instructionCode, uint8_t payloadSize);  // Returns the instruction status (INSTRUCTION_STATUS_*)
+    void executeBatch();
+    void executeIfChanged();
+    bool hasInstructionChangedSince(uint8_t instructionCode, uint8_t payloadSize, uint32_t sinceVersion);
+    void sendResponse(uint8_t responseCode);
+    void sendNak(uint8_t reason);
+    uint8_t getNakReason(uint8_t instructionStatus);  // NAK_REASON_* of a failed instruction
+    void transmitResponse();                          // Writes the pending response bytes that fit in the serial Tx buffer
+    uint8_t getResponseFrameByte(uint16_t index);
 
-    void handleRequest(uint8_t requestCode);
-    void sendResponse();
+    void getSnapshot(PLCSnapshot& snapshot);
+    void writeChangesSince(uint32_t sinceVersion, uint8_t firstField);
+    uint8_t writeFieldValue(uint8_t field);   // Returns the instruction status (INSTRUCTION_STATUS_*)
+    void writeScheduleGroups(uint8_t firstGroupIdx, uint8_t groupsCount);
+    void writeInstructionStatistics(uint8_t firstSlotIdx);
+    void writeThreadStatistics(uint8_t firstSlotIdx);
+    void writeConfigImage(uint16_t offset);
 
     uint32_t readRequestPayloadInt(uint8_t bytesCount);                  // Parse ${bytesCount} bytes of the rx payload buffer as an int
     void     readRequestPayload(uint8_t* bufferPtr, uint8_t bytesCount); // Copy ${bytesCount} bytes of the rx payload buffer to the supplied buffer (bufferPtr)
@@ -81,8 +301,7 @@ class CommunicationsThread: public Thread
     bool checkParity(uint8_t* bytePtr);
     bool checkParity(uint8_t* startPtr, uint8_t size);
 
-    bool checkRequestParity();
-    bool checkResponseParity();
+    bool checkResponseParity(uint8_t responseCode);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+#ifndef CommunicationsTypes_h
+#define CommunicationsTypes_h
+
+#include <Arduino.h>
+
+/*
+    Packed snapshot of the whole PLC state, returned by the GET_PLC_SNAPSHOT_ADDR instruction.
+
+    The layout is versioned via the 'version' field (PLC_SNAPSHOT_VERSION); any change to the layout of the struct
+    must increment the version so that the API server can decode older/newer PLCs.
+    All multi-byte values are little endian (as every other instruction response).
+*/
+
+#define PLC_SNAPSHOT_VERSION 1
+
+// PLCSnapshot.flags bits
+#define SNAPSHOT_AUTO_MODE_BIT                 0
+
+// PLCSnapshot.spFlags bits
+#define SNAPSHOT_SP_PUMP_STATE_BIT             0
+#define SNAPSHOT_SP_UV_STATE_BIT               1
+#define SNAPSHOT_SP_PUMP_MANUAL_VALUE_BIT      2
+#define SNAPSHOT_SP_UV_ENABLE_VALUE_BIT        3
+#define SNAPSHOT_SP_FLOW_SENSOR_VALUE_BIT      4
+#define SNAPSHOT_SP_PUMP_MANUAL_DISABLE_BIT    5
+#define SNAPSHOT_SP_SCHEDULE_ENABLE_BIT        6
+
+// PLCSnapshot.irrFlags bits
+#define SNAPSHOT_IRR_PUMP_STATE_BIT            0
+#define SNAPSHOT_IRR_MAINS_INLET_STATE_BIT     1
+#define SNAPSHOT_IRR_MANUAL_VALUE_BIT          2
+#define SNAPSHOT_IRR_PRESSURE_SENSOR_VALUE_BIT 3
+#define SNAPSHOT_IRR_MANUAL_DISABLE_BIT        4
+#define SNAPSHOT_IRR_SCHEDULE_ENABLE_BIT       5
+#define SNAPSHOT_IRR_SCHEDULE_PAUSED_BIT       6
+
+struct __attribute__((packed)) PLCSnapshot {
+    uint8_t  version;                   // PLC_SNAPSHOT_VERSION
+
+    // Global
+    uint32_t time;                      // PLC clock (UNIX timestamp)
+    uint32_t lastChangeTimestamp;       // Task scheduler last change timestamp
+    uint8_t  flags;                     // SNAPSHOT_*_BIT
+
+    // Swimming Pool
+    uint32_t spLastChangeTimestamp;
+    uint8_t  spControllerState;
+    uint8_t  spFlags;                   // SNAPSHOT_SP_*_BIT
+    uint32_t spScheduleNextTime;
+    uint16_t spScheduleDuration;
+    uint8_t  spSchedulePeriod;
+
+    // Irrigation
+    uint32_t irrLastChangeTimestamp;
+    uint8_t  irrControllerState;
+    uint8_t  irrFlags;                  // SNAPSHOT_IRR_*_BIT
+    uint16_t irrZonesState;
+    uint16_t irrManualZones;
+    uint8_t  irrManualSource;
+    uint32_t irrScheduleResumeTime;
+    uint32_t irrNextIrrigationTime;
+    uint16_t irrGroupsState;
+};
+
+
+
+/*
+    Communication statistics, returned by the GET_COMM_LINK_STATS_ADDR and GET_COMM_INSTRUCTION_STATS_ADDR 
+    instructions (see CommunicationStatistics.h). Counters saturate instead of wrapping around.
+*/
+
+struct __attribute__((packed)) LinkStatistics {
+    uint32_t bytesReceived;
+    uint32_t bytesSent;
+    uint16_t requestsHandled;
+    uint16_t crcErrors;                 // CRC-16/parity check failures
+    uint16_t timeouts;                  // Requests abandoned due to the inter-byte timeout
+    uint16_t rejectedRequests;          // Unknown instructions/unexpected payload sizes
+    uint16_t rxOverruns;                // Requests dropped or rejected because the request queue/Rx buffer was full
+    uint16_t untrackedRequests;         // Requests not tracked per instruction (instruction statistics table full)
+    uint16_t framingErrors;             // Frames without the trailing NULL character
+};
+
+struct __attribute__((packed)) InstructionStatistics {
+    uint8_t  code;
+    uint16_t count;                     // count, errors and totalTime stop together once count or totalTime saturates
+    uint16_t errors;                    // Requests not completed successfully (responded with a NAK)
+    uint16_t maxTime;                   // Maximum handling time in microseconds
+    uint32_t totalTime;                 // Total handling time in microseconds (average = totalTime/count)
+};
+
+
+
+/*
+    Thread loop timing statistics, returned by the GET_THREAD_STATS_ADDR instruction (see TimedThreadController.h).
+    Counters saturate instead of wrapping around.
+*/
+
+#define THREAD_LATENESS_BUCKETS 5       // Lateness histogram buckets: < 1 ms, < 2 ms, < 4 ms, < 8 ms, >= 8 ms
+
+struct __attribute__((packed)) ThreadStatistics {
+    uint32_t runs;
+    uint16_t averageTime;               // Average execution time in microseconds (moving average over the last ~16 runs)
+    uint16_t maxTime;                   // Maximum execution time in microseconds
+    uint16_t lateness[THREAD_LATENESS_BUCKETS];   // Runs per lateness (time since the thread was due)
+};
+
+#endif
@@ -0,0 +1,502 @@
+#include "InstructionTable.h"
+
+#include "CommunicationsThread.h"
+#include "ProtocolDefinition.h"
+
+
+// Instruction handlers *********************************************************************************************************
+
+struct InstructionHandlers {
+
+  // Global Instructions
+  static void getPlcLastChange(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.taskSchedulerThread->getLastChangeTimestamp());
+  }
+
+  static void getAutoValue(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.taskSchedulerThread->getAutoModeState());
+  }
+
+  static void getPlcSnapshot(CommunicationsThread& comm) {
+    PLCSnapshot snapshot;
+    comm.getSnapshot(snapshot);
+    comm.writeResponsePayload((uint8_t*) &snapshot, sizeof(PLCSnapshot));
+  }
+
+  static void batch(CommunicationsThread& comm) {
+    comm.executeBatch();
+  }
+
+  static void getClock(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.taskSchedulerThread->getTime());
+  }
+
+  static void setClock(CommunicationsThread& comm) {
+    comm.taskSchedulerThread->setTime(comm.readRequestPayloadInt(4));
+
+    // Cancel all active jobs after clock change, as the finish timestamps will be corrupted
+    comm.swimmingPoolController->stopJob();
+    comm.electrovavlesThread->cancelAllJobs();
+  }
+
+  static void getChangesSince(CommunicationsThread& comm) {
+    const uint32_t sinceVersion = comm.readRequestPayloadInt(4);
+    comm.writeChangesSince(sinceVersion, comm.readRequestPayloadInt(1));
+  }
+
+  static void getCommLinkStats(CommunicationsThread& comm) {
+    comm.writeResponsePayload((uint8_t*) &comm.statistics.getLink(), sizeof(LinkStatistics));
+  }
+
+  static void getCommInstructionStats(CommunicationsThread& comm) {
+    comm.writeInstructionStatistics(comm.readRequestPayloadInt(1));
+  }
+
+  static void resetCommStats(CommunicationsThread& comm) {
+    comm.statistics.reset();
+  }
+
+  static void getThreadStats(CommunicationsThread& comm) {
+    comm.writeThreadStatistics(comm.readRequestPayloadInt(1));
+  }
+
+  static void resetThreadStats(CommunicationsThread& comm) {
+    comm.threadController->reset();
+  }
+
+  static void getIfChanged(CommunicationsThread& comm) {
+    comm.executeIfChanged();
+  }
+
+  static void getConfigImage(CommunicationsThread& comm) {
+    comm.writeConfigImage(comm.readRequestPayloadInt(2));
+  }
+
+  static void stageConfigImage(CommunicationsThread& comm) {
+    if (comm.instructionPayloadSize < 2) {
+      comm.instructionStatus = INSTRUCTION_STATUS_MALFORMED;
+      return;
+    }
+
+    const uint16_t offset = comm.readRequestPayloadInt(2);
+    comm.writeResponsePayload(comm.dataSaver->stageConfigImage(offset, comm.rxPayloadBufferNextPtr, comm.instructionPayloadSize - 2));
+  }
+
+  static void commitConfigImage(CommunicationsThread& comm) {
+    const bool committed = comm.dataSaver->commitConfigImage();
+    if (committed) {
+      // Cancel all active jobs, as they were started with the previous configuration
+      comm.swimmingPoolController->stopJob();
+      comm.electrovavlesThread->cancelAllJobs();
+
+      comm.irrigationController->reload();
+      comm.swimmingPoolController->reload();
+    }
+    comm.writeResponsePayload(committed);
+  }
+
+
+  // Swimming Pool Instructions
+  static void spGetLastChange(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.swimmingPoolController->getLastChangeTimestamp());
+  }
+
+  static void spGetControllerState(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.swimmingPoolController->getControllerState());
+  }
+
+  static void spGetPumpState(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.swimmingPoolController->swimmingPoolRecirculationPump->getState());
+  }
+
+  static void spGetUVState(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.swimmingPoolController->uvDisinfectLight->getState());
+  }
+
+  static void spGetPumpManualValue(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.swimmingPoolController->manualOverride->value());
+  }
+
+  static void spGetUVEnableValue(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.swimmingPoolController->UVEnable->value());
+  }
+
+  static void spGetFlowSensorValue(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.swimmingPoolController->recirculationSensor->value());
+  }
+
+  static void spGetPumpManualDisable(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.swimmingPoolController->getRecirculationPumpManualOverrideLockState());
+  }
+
+  static void spGetScheduleEnable(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.swimmingPoolController->isScheduleEnabled());
+  }
+
+  static void spSetScheduleEnable(CommunicationsThread& comm) {
+    if (comm.readRequestPayloadInt(1) == 0) comm.swimmingPoolController->disableSchedule();
+    else                                    comm.swimmingPoolController->enableSchedule();
+  }
+
+  static void spGetScheduleNext(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.swimmingPoolController->getNextTurnOnTime());
+  }
+
+  static void spSetScheduleNext(CommunicationsThread& comm) {
+    comm.swimmingPoolController->setNextTurnOnTime(comm.readRequestPayloadInt(4));
+  }
+
+  static void spGetScheduleDuration(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.swimmingPoolController->getDuration());
+  }
+
+  static void spSetScheduleDuration(CommunicationsThread& comm) {
+    comm.swimmingPoolController->setDuration(comm.readRequestPayloadInt(2));
+  }
+
+  static void spGetSchedulePeriod(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.swimmingPoolController->getPeriodDays());
+  }
+
+  static void spSetSchedulePeriod(CommunicationsThread& comm) {
+    comm.swimmingPoolController->setPeriodDays(comm.readRequestPayloadInt(1));
+  }
+
+  static void spReqScheduleReset(CommunicationsThread& comm) {
+    if (comm.readRequestPayloadInt(2) == 0xAA00) comm.swimmingPoolController->reset();
+  }
+
+
+  // Irrigation Instructions
+  static void irrGetLastChange(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getLastChangeTimestamp());
+  }
+
+  static void irrGetControllerState(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getControllerState());
+  }
+
+  static void irrGetPumpState(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.electrovavlesThread->swimmingPoolIrrigationPump->getState());
+  }
+
+  static void irrGetMainsInletState(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.electrovavlesThread->mainsWaterInletValve->getState());
+  }
+
+  static void irrGetManualValue(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->manualIrrigationEnable->value());
+  }
+
+  static void irrGetPressureSensorValue(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->irrigationPressureSensor->value());
+  }
+
+  static void irrGetManualDisableState(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getManualOverrideLockState());
+  }
+
+  static void irrGetZonesState(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getZonesState());
+  }
+
+  static void irrGetManualZones(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getIrrigationManualZones());
+  }
+
+  static void irrSetManualZones(CommunicationsThread& comm) {
+    comm.irrigationController->setIrrigationManualZones(comm.readRequestPayloadInt(2));
+  }
+
+  static void irrGetManualSource(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getIrrigationManualSource());
+  }
+
+  static void irrSetManualSource(CommunicationsThread& comm) {
+    comm.irrigationController->setIrrigationManualSource(comm.readRequestPayloadInt(1));
+  }
+
+  static void irrGetScheduleEnable(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->isScheduleEnabled());
+  }
+
+  static void irrSetScheduleEnable(CommunicationsThread& comm) {
+    if (comm.readRequestPayloadInt(1) == 0) comm.irrigationController->disableSchedule();
+    else                                    comm.irrigationController->enableSchedule();
+  }
+
+  static void irrGetSchedulePausedState(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->isSchedulePaused());
+  }
+
+  static void irrSetSchedulePauseTimestamp(CommunicationsThread& comm) {
+    comm.irrigationController->pauseSchedule(comm.readRequestPayloadInt(4));
+  }
+
+  static void irrReqScheduleResume(CommunicationsThread& comm) {
+    if (comm.readRequestPayloadInt(1) != 0) comm.irrigationController->resumeSchedule();
+  }
+
+  static void irrGetScheduleResumeTime(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getScheduleResumeTime());
+  }
+
+  static void irrGetNextIrrigationTime(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getNextIrrigationTime());
+  }
+
+  static void irrGetScheduleGroupsState(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getGroupsEnableState());
+  }
+
+  static void irrGetScheduleGroupState(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->isGroupEnabled(comm.readRequestPayloadInt(1)));
+  }
+
+  static void irrSetScheduleGroupState(CommunicationsThread& comm) {
+    const uint8_t groupIdx = comm.readRequestPayloadInt(1);
+    if (comm.readRequestPayloadInt(1) == 0) comm.irrigationController->disableGroup(groupIdx);
+    else                                    comm.irrigationController->enableGroup(groupIdx);
+  }
+
+  static void irrGetScheduleGroupName(CommunicationsThread& comm) {
+    IrrigationGroupName groupName;
+    comm.irrigationController->getGroupName(comm.readRequestPayloadInt(1), groupName);
+    comm.writeResponsePayload((uint8_t*) &groupName, IRRIGATION_GROUP_NAME_LENGTH);
+  }
+
+  static void irrSetScheduleGroupName(CommunicationsThread& comm) {
+    IrrigationGroupName groupName;
+    const uint8_t groupIdx = comm.readRequestPayloadInt(1);
+    comm.readRequestPayload((uint8_t*) &groupName, IRRIGATION_GROUP_NAME_LENGTH);
+    comm.irrigationController->setGroupName(groupIdx, groupName);
+  }
+
+  static void irrGetScheduleGroupZones(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getGroupZones(comm.readRequestPayloadInt(1)));
+  }
+
+  static void irrSetScheduleGroupZones(CommunicationsThread& comm) {
+    const uint8_t groupIdx = comm.readRequestPayloadInt(1);
+    comm.irrigationController->setGroupZones(groupIdx, comm.readRequestPayloadInt(2));
+  }
+
+  static void irrGetScheduleGroupSource(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getGroupSource(comm.readRequestPayloadInt(1)));
+  }
+
+  static void irrSetScheduleGroupSource(CommunicationsThread& comm) {
+    const uint8_t groupIdx = comm.readRequestPayloadInt(1);
+    comm.irrigationController->setGroupSource(groupIdx, comm.readRequestPayloadInt(1));
+  }
+
+  static void irrGetScheduleGroupPeriod(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getGroupPeriod(comm.readRequestPayloadInt(1)));
+  }
+
+  static void irrSetScheduleGroupPeriod(CommunicationsThread& comm) {
+    const uint8_t groupIdx = comm.readRequestPayloadInt(1);
+    comm.irrigationController->setGroupPeriod(groupIdx, comm.readRequestPayloadInt(1));
+  }
+
+  static void irrGetScheduleGroupDuration(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getGroupDuration(comm.readRequestPayloadInt(1)));
+  }
+
+  static void irrSetScheduleGroupDuration(CommunicationsThread& comm) {
+    const uint8_t groupIdx = comm.readRequestPayloadInt(1);
+    comm.irrigationController->setGroupDuration(groupIdx, comm.readRequestPayloadInt(2));
+  }
+
+  static void irrGetScheduleGroupInitTime(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getGroupInitTime(comm.readRequestPayloadInt(1)));
+  }
+
+  static void irrSetScheduleGroupInitTime(CommunicationsThread& comm) {
+    const uint8_t groupIdx = comm.readRequestPayloadInt(1);
+    comm.irrigationController->setGroupInitTime(groupIdx, comm.readRequestPayloadInt(2));
+  }
+
+  static void irrGetScheduleGroupNextTime(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getGroupNextIrrigationTime(comm.readRequestPayloadInt(1)));
+  }
+
+  static void irrGetScheduleGroups(CommunicationsThread& comm) {
+    const uint8_t firstGroupIdx = comm.readRequestPayloadInt(1);
+    comm.writeScheduleGroups(firstGroupIdx, comm.readRequestPayloadInt(1));
+  }
+
+  static void irrGetDroppedJobs(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->getDroppedJobsCount());
+  }
+
+  static void irrSetScheduleGroup(CommunicationsThread& comm) {
+    IrrigationGroup irrGroup;
+    const uint8_t groupIdx = comm.readRequestPayloadInt(1);
+    comm.readRequestPayload((uint8_t*) &irrGroup, sizeof(IrrigationGroup));
+    comm.writeResponsePayload(comm.irrigationController->setGroup(groupIdx, irrGroup));
+  }
+
+  static void irrReqScheduleGroupNow(CommunicationsThread& comm) {
+    // Empty response for the existing clients (see irrReqScheduleGroupNowStatus)
+    comm.irrigationController->scheduleGroupNow(comm.readRequestPayloadInt(1));
+  }
+
+  static void irrReqScheduleGroupNowStatus(CommunicationsThread& comm) {
+    comm.writeResponsePayload(comm.irrigationController->scheduleGroupNow(comm.readRequestPayloadInt(1)));
+  }
+
+  static void irrReqCancelCurrentJob(CommunicationsThread& comm) {
+    if (comm.readRequestPayloadInt(1) != 0) comm.electrovavlesThread->cancelCurrentJob();
+  }
+
+  static void irrReqCancelAllJobs(CommunicationsThread& comm) {
+    if (comm.readRequestPayloadInt(1) != 0) comm.electrovavlesThread->cancelAllJobs();
+  }
+
+  static void irrReqScheduleGroupReset(CommunicationsThread& comm) {
+    const uint8_t groupIdx = comm.readRequestPayloadInt(1);
+    if (comm.readRequestPayloadInt(2) == 0xBB01) comm.irrigationController->resetGroup(groupIdx);
+  }
+
+  static void irrReqScheduleReset(CommunicationsThread& comm) {
+    if (comm.readRequestPayloadInt(2) == 0xBA00) comm.irrigationController->reset();
+  }
+
+};
+
+
+
+// Instruction table ************************************************************************************************************
+
+#define R INSTRUCTION_READ
+#define W INSTRUCTION_WRITE
+#define B INSTRUCTION_BROADCAST
+#define V INSTRUCTION_VARIABLE_SIZE
+#define H InstructionHandlers
+
+// NOTE: The table must be sorted by instruction code
+static constexpr InstructionDefinition instructionTable[] PROGMEM = {
+  // Code                                     Request size                       Response size                     Flags  Handler
+
+  // Global Instructions
+  { GET_PLC_LAST_CHANGE_ADDR,                 0,                                 4,                                R,     &H::getPlcLastChange             },
+  { GET_AUTO_VALUE_ADDR,                      0,                                 1,                                R,     &H::getAutoValue                 },
+  { GET_PLC_SNAPSHOT_ADDR,                    0,                                 sizeof(PLCSnapshot),              R,     &H::getPlcSnapshot               },
+  { BATCH_ADDR,                               V,                                 V,                                R | W, &H::batch                        },
+  { GET_CLOCK_ADDR,                           0,                                 4,                                R,     &H::getClock                     },
+  { SET_CLOCK_ADDR,                           4,                                 0,                                W | B, &H::setClock                     },
+  { GET_CHANGES_SINCE_ADDR,                   5,                                 V,                                R,     &H::getChangesSince              },
+  { GET_COMM_LINK_STATS_ADDR,                 0,                                 sizeof(LinkStatistics),           R,     &H::getCommLinkStats             },
+  { GET_COMM_INSTRUCTION_STATS_ADDR,          1,                                 V,                                R,     &H::getCommInstructionStats      },
+  { RESET_COMM_STATS_ADDR,                    0,                                 0,                                W,     &H::resetCommStats               },
+  { GET_IF_CHANGED_ADDR,                      V,                                 V,                                R,     &H::getIfChanged                 },
+  { GET_CONFIG_IMAGE_ADDR,                    2,                                 V,                                R,     &H::getConfigImage               },
+  { STAGE_CONFIG_IMAGE_ADDR,                  V,                                 1,                                W,     &H::stageConfigImage             },
+  { COMMIT_CONFIG_IMAGE_ADDR,                 0,                                 1,                                W,     &H::commitConfigImage            },
+  { GET_THREAD_STATS_ADDR,                    1,                                 V,                                R,     &H::getThreadStats               },
+  { RESET_THREAD_STATS_ADDR,                  0,                                 0,                                W,     &H::resetThreadStats             },
+
+  // Swimming Pool Instructions
+  { SP_GET_LAST_CHANGE_ADDR,                  0,                                 4,                                R,     &H::spGetLastChange              },
+  { SP_GET_CONTROLLER_STATE_ADDR,             0,                                 1,                                R,     &H::spGetControllerState         },
+  { SP_GET_PUMP_STATE_ADDR,                   0,                                 1,                                R,     &H::spGetPumpState               },
+  { SP_GET_UV_STATE_ADDR,                     0,                                 1,                                R,     &H::spGetUVState                 },
+  { SP_GET_PUMP_MANUAL_VALUE_ADDR,            0,                                 1,                                R,     &H::spGetPumpManualValue         },
+  { SP_GET_UV_ENABLE_VALUE_ADDR,              0,                                 1,                                R,     &H::spGetUVEnableValue           },
+  { SP_GET_FLOW_SENSOR_VALUE_ADDR,            0,                                 1,                                R,     &H::spGetFlowSensorValue         },
+  { SP_GET_PUMP_MANUAL_DISABLE_ADDR,          0,                                 1,                                R,     &H::spGetPumpManualDisable       },
+  { SP_GET_SCHEDULE_ENABLE_ADDR,              0,                                 1,                                R,     &H::spGetScheduleEnable          },
+  { SP_SET_SCHEDULE_ENABLE_ADDR,              1,                                 0,                                W,     &H::spSetScheduleEnable          },
+  { SP_GET_SCHEDULE_NEXT_ADDR,                0,                                 4,                                R,     &H::spGetScheduleNext            },
+  { SP_SET_SCHEDULE_NEXT_ADDR,                4,                                 0,                                W,     &H::spSetScheduleNext            },
+  { SP_GET_SCHEDULE_DURATION_ADDR,            0,                                 2,                                R,     &H::spGetScheduleDuration        },
+  { SP_SET_SCHEDULE_DURATION_ADDR,            2,                                 0,                                W,     &H::spSetScheduleDuration        },
+  { SP_GET_SCHEDULE_PERIOD_ADDR,              0,                                 1,                                R,     &H::spGetSchedulePeriod          },
+  { SP_SET_SCHEDULE_PERIOD_ADDR,              1,                                 0,                                W,     &H::spSetSchedulePeriod          },
+  { SP_REQ_SCHEDULE_RESET_ADDR,               2,                                 0,                                W,     &H::spReqScheduleReset           },
+
+  // Irrigation Instructions
+  { IRR_GET_LAST_CHANGE_ADDR,                 0,                                 4,                                R,     &H::irrGetLastChange             },
+  { IRR_GET_CONTROLLER_STATE_ADDR,            0,                                 1,                                R,     &H::irrGetControllerState        },
+  { IRR_GET_PUMP_STATE_ADDR,                  0,                                 1,                                R,     &H::irrGetPumpState              },
+  { IRR_GET_MAINS_INLET_STATE_ADDR,           0,                                 1,                                R,     &H::irrGetMainsInletState        },
+  { IRR_GET_MANUAL_VALUE_ADDR,                0,                                 1,                                R,     &H::irrGetManualValue            },
+  { IRR_GET_PRESSURE_SENSOR_VALUE_ADDR,       0,                                 1,                                R,     &H::irrGetPressureSensorValue    },
+  { IRR_GET_MANUAL_DISABLE_STATE_ADDR,        0,                                 1,                                R,     &H::irrGetManualDisableState     },
+  { IRR_GET_ZONES_STATE_ADDR,                 0,                                 2,                                R,     &H::irrGetZonesState             },
+  { IRR_GET_MANUAL_ZONES_ADDR,                0,                                 2,                                R,     &H::irrGetManualZones            },
+  { IRR_SET_MANUAL_ZONES_ADDR,                2,                                 0,                                W,     &H::irrSetManualZones            },
+  { IRR_GET_MANUAL_SOURCE_ADDR,               0,                                 1,                                R,     &H::irrGetManualSource           },
+  { IRR_SET_MANUAL_SOURCE_ADDR,               1,                                 0,                                W,     &H::irrSetManualSource           },
+  { IRR_GET_SCHEDULE_ENABLE_ADDR,             0,                                 1,                                R,     &H::irrGetScheduleEnable         },
+  { IRR_SET_SCHEDULE_ENABLE_ADDR,             1,                                 0,                                W,     &H::irrSetScheduleEnable         },
+  { IRR_GET_SCHEDULE_PAUSED_STATE_ADDR,       0,                                 1,                                R,     &H::irrGetSchedulePausedState    },
+  { IRR_SET_SCHEDULE_PAUSE_TIMESTAMP_ADDR,    4,                                 0,                                W,     &H::irrSetSchedulePauseTimestamp },
+  { IRR_REQ_SCHEDULE_RESUME_ADDR,             1,                                 0,                                W,     &H::irrReqScheduleResume         },
+  { IRR_GET_SCHEDULE_RESUME_TIME_ADDR,        0,                                 4,                                R,     &H::irrGetScheduleResumeTime     },
+  { IRR_GET_NEXT_IRRIGATION_TIME_ADDR,        0,                                 4,                                R,     &H::irrGetNextIrrigationTime     },
+  { IRR_GET_SCHEDULE_GROUPS_STATE_ADDR,       0,                                 2,                                R,     &H::irrGetScheduleGroupsState    },
+  { IRR_GET_SCHEDULE_GROUP_STATE_ADDR,        1,                                 1,                                R,     &H::irrGetScheduleGroupState     },
+  { IRR_SET_SCHEDULE_GROUP_STATE_ADDR,        2,                                 0,                                W,     &H::irrSetScheduleGroupState     },
+  { IRR_GET_SCHEDULE_GROUP_NAME_ADDR,         1,                                 IRRIGATION_GROUP_NAME_LENGTH,     R,     &H::irrGetScheduleGroupName      },
+  { IRR_SET_SCHEDULE_GROUP_NAME_ADDR,         1 + IRRIGATION_GROUP_NAME_LENGTH,  0,                                W,     &H::irrSetScheduleGroupName      },
+  { IRR_GET_SCHEDULE_GROUP_ZONES_ADDR,        1,                                 2,                                R,     &H::irrGetScheduleGroupZones     },
+  { IRR_SET_SCHEDULE_GROUP_ZONES_ADDR,        3,                                 0,                                W,     &H::irrSetScheduleGroupZones     },
+  { IRR_GET_SCHEDULE_GROUP_SOURCE_ADDR,       1,                                 1,                                R,     &H::irrGetScheduleGroupSource    },
+  { IRR_SET_SCHEDULE_GROUP_SOURCE_ADDR,       2,                                 0,                                W,     &H::irrSetScheduleGroupSource    },
+  { IRR_GET_SCHEDULE_GROUP_PERIOD_ADDR,       1,                                 1,                                R,     &H::irrGetScheduleGroupPeriod    },
+  { IRR_SET_SCHEDULE_GROUP_PERIOD_ADDR,       2,                                 0,                                W,     &H::irrSetScheduleGroupPeriod    },
+  { IRR_GET_SCHEDULE_GROUP_DURATION_ADDR,     1,                                 2,                                R,     &H::irrGetScheduleGroupDuration  },
+  { IRR_SET_SCHEDULE_GROUP_DURATION_ADDR,     3,                                 0,                                W,     &H::irrSetScheduleGroupDuration  },
+  { IRR_GET_SCHEDULE_GROUP_INIT_TIME_ADDR,    1,                                 2,                                R,     &H::irrGetScheduleGroupInitTime  },
+  { IRR_SET_SCHEDULE_GROUP_INIT_TIME_ADDR,    3,                                 0,                                W,     &H::irrSetScheduleGroupInitTime  },
+  { IRR_GET_SCHEDULE_GROUP_NEXT_TIME_ADDR,    1,                                 4,                                R,     &H::irrGetScheduleGroupNextTime  },
+  { IRR_REQ_SCHEDULE_GROUP_NOW_ADDR,          1,                                 0,                                W,     &H::irrReqScheduleGroupNow       },
+  { IRR_REQ_CANCEL_CURRENT_JOB_ADDR,          1,                                 0,                                W,     &H::irrReqCancelCurrentJob       },
+  { IRR_REQ_CANCEL_ALL_JOBS_ADDR,             1,                                 0,                                W | B, &H::irrReqCancelAllJobs          },
+  { IRR_REQ_SCHEDULE_GROUP_RESET_ADDR,        3,                                 0,                                W,     &H::irrReqScheduleGroupReset     },
+  { IRR_REQ_SCHEDULE_RESET_ADDR,              2,                                 0,                                W,     &H::irrReqScheduleReset          },
+  { IRR_GET_SCHEDULE_GROUPS_ADDR,             2,                                 V,                                R,     &H::irrGetScheduleGroups         },
+  { IRR_SET_SCHEDULE_GROUP_ADDR,              1 + sizeof(IrrigationGroup),       1,                                W,     &H::irrSetScheduleGroup          },
+  { IRR_GET_DROPPED_JOBS_ADDR,                0,                                 2,                                R,     &H::irrGetDroppedJobs            },
+  { IRR_REQ_SCHEDULE_GROUP_NOW_STATUS_ADDR,   1,                                 1,                                W,     &H::irrReqScheduleGroupNowStatus },
+};
+
+#undef R
+#undef W
+#undef B
+#undef V
+#undef H
+
+static constexpr uint8_t INSTRUCTIONS_COUNT = sizeof(instructionTable) / sizeof(InstructionDefinition);
+
+static constexpr bool isTableSorted(const InstructionDefinition* table, uint8_t size) {
+  return size < 2 || (table[0].code < table[1].code && isTableSorted(table + 1, size - 1));
+}
+
+static_assert(isTableSorted(instructionTable, INSTRUCTIONS_COUNT), "The instruction table must be sorted by instruction code");
+
+
+
+// Instruction lookup ***********************************************************************************************************
+
+bool findInstruction(const uint8_t code, InstructionDefinition& instruction) {
+  // Binary search
+  uint8_t low  = 0;
+  uint8_t high = INSTRUCTIONS_COUNT;
+
+  while (low < high) {
+    const uint8_t middle     = (low + high) / 2;
+    const uint8_t middleCode = pgm_read_byte(&instructionTable[middle].code);
+
+    if      (middleCode < code) low  = middle + 1;
+    else if (middleCode > code) high = middle;
+    else {
+      memcpy_P(&instruction, &instructionTable[middle], sizeof(InstructionDefinition));
+      return true;
+    }
+  }
+
+  return false;
+}
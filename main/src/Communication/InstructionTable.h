@@ -0,0 +1,38 @@
+/*
+  InstructionTable.h
+
+  Compile-time table of the instructions supported by the CommunicationsThread. Each instruction is defined by:
+    - Its instruction code (see ProtocolDefinition.h)
+    - The expected request payload size
+    - The response payload size (used to check beforehand whether the response will fit in the Tx buffer)
+    - Its access class (read/write), and whether it may be broadcast to every node on the bus
+    - The handler function, which reads the request payload and writes the response payload
+
+  The table is stored in flash memory (PROGMEM), sorted by instruction code, and searched with a binary search.
+*/
+#ifndef InstructionTable_h
+#define InstructionTable_h
+
+#include <Arduino.h>
+
+#define INSTRUCTION_VARIABLE_SIZE 0xFF    // The request/response payload size is validated by the handler
+
+// Instruction flags
+#define INSTRUCTION_READ      0x1
+#define INSTRUCTION_WRITE     0x2
+#define INSTRUCTION_BROADCAST 0x4   // May be sent to COMM_BROADCAST_ADDRESS
+
+class CommunicationsThread;
+
+struct InstructionDefinition {
+    uint8_t code;
+    uint8_t requestSize;
+    uint8_t responseSize;
+    uint8_t flags;
+    void    (*handler)(CommunicationsThread& comm);
+};
+
+// Copies the definition of the instruction to 'instruction'. Returns false if the instruction is unknown
+bool findInstruction(const uint8_t code, InstructionDefinition& instruction);
+
+#endif
@@ -6,13 +6,47 @@
 */
 
 
+// Framing
+#define FRAME_START_MARKER          0xA5    // Start of a CRC-16 frame. Must not be used as an instruction address
+#define FRAME_SEQ_START_MARKER      0xA6    // Start of a CRC-16 frame with a sequence number. Must not be used as an instruction address
+#define FRAME_NAK_CODE              0xFF    // Code of the CRC-16 frames sent when a request is rejected
+
+#define COMM_BROADCAST_ADDRESS      0x0     // Node address of the requests handled by every node (no response is sent)
+
+#define NAK_REASON_CRC              0x1     // CRC-16 check failed
+#define NAK_REASON_LENGTH           0x2     // Unexpected payload size for the instruction, or larger than the Rx buffer
+#define NAK_REASON_UNKNOWN          0x3     // Unknown instruction (or instruction that cannot be broadcast)
+#define NAK_REASON_BUSY             0x4     // Not enough space left in the Rx buffer for the request, retry later
+#define NAK_REASON_FRAMING          0x5     // The frame does not end with the NULL character
+#define NAK_REASON_MALFORMED        0x6     // Invalid payload contents (INSTRUCTION_STATUS_MALFORMED)
+#define NAK_REASON_NO_SPACE         0x7     // The response does not fit in the Tx buffer (INSTRUCTION_STATUS_NO_SPACE)
+#define NAK_REASON_REJECTED         0x8     // The request cannot be executed (INSTRUCTION_STATUS_REJECTED)
+
+
 // Global
 #define GET_PLC_LAST_CHANGE_ADDR   0x1
 #define GET_AUTO_VALUE_ADDR        0x2
+#define GET_PLC_SNAPSHOT_ADDR      0x3    // Returns a PLCSnapshot (see CommunicationsTypes.h)
+#define BATCH_ADDR                 0x4    // Executes multiple instructions in a single request (see CommunicationsThread.h)
 
 #define GET_CLOCK_ADDR             0x5
 #define SET_CLOCK_ADDR             0x6
 
+#define GET_CHANGES_SINCE_ADDR     0x7    // Returns the fields changed since the given change version (see CommunicationsThread.h)
+
+#define GET_COMM_LINK_STATS_ADDR          0x8    // Returns the LinkStatistics (see CommunicationsTypes.h)
+#define GET_COMM_INSTRUCTION_STATS_ADDR   0x9    // Returns a range of InstructionStatistics (see CommunicationsThread.h)
+#define RESET_COMM_STATS_ADDR             0xA
+
+#define GET_IF_CHANGED_ADDR        0xB    // Executes a GET instruction only if its value changed since the given change version (see CommunicationsThread.h)
+
+#define GET_CONFIG_IMAGE_ADDR      0xC    // Returns a chunk of the configuration image (see CommunicationsThread.h)
+#define STAGE_CONFIG_IMAGE_ADDR    0xD    // Writes a chunk of the imported configuration image to the staging area
+#define COMMIT_CONFIG_IMAGE_ADDR   0xE    // Validates the staged configuration image and replaces the configuration with it
+
+#define GET_THREAD_STATS_ADDR      0xF    // Returns a range of ThreadStatistics (see CommunicationsThread.h)
+#define RESET_THREAD_STATS_ADDR    0x10
+
 
 
 // Swimming Pool
@@ -103,5 +137,28 @@
 #define IRR_REQ_SCHEDULE_GROUP_RESET_ADDR       0x8A
 #define IRR_REQ_SCHEDULE_RESET_ADDR             0x8B 
 
+#define IRR_GET_SCHEDULE_GROUPS_ADDR            0x8C    // Returns a range of IrrigationGroup structs (see CommunicationsThread.h)
+#define IRR_SET_SCHEDULE_GROUP_ADDR             0x8D    // Sets a whole IrrigationGroup struct (see CommunicationsThread.h)
+
+#define IRR_GET_DROPPED_JOBS_ADDR               0x8E    // Returns the count of group jobs dropped because the job queue was full
+#define IRR_REQ_SCHEDULE_GROUP_NOW_STATUS_ADDR  0x8F    // Same as IRR_REQ_SCHEDULE_GROUP_NOW_ADDR, returns false if the manual schedule queue is full
+
+
+
+// GET_CHANGES_SINCE_ADDR response 'next field' value once all the changed fields have been returned
+#define CHANGES_SINCE_COMPLETE         0xFF
+
+// GET_IF_CHANGED_ADDR response status
+#define IF_CHANGED_NOT_MODIFIED        0x0
+#define IF_CHANGED_MODIFIED            0x1
+
+
+// Batch sub-instruction status codes (single requests that fail are NAKed with the matching NAK_REASON_*)
+#define INSTRUCTION_STATUS_OK          0x0
+#define INSTRUCTION_STATUS_UNKNOWN     0x1    // Unknown (or nested batch) instruction, not executed
+#define INSTRUCTION_STATUS_MALFORMED   0x2    // Unexpected payload size for the instruction (or exceeds the batch payload), not executed
+#define INSTRUCTION_STATUS_NO_SPACE    0x3    // The response does not fit in the batch response. Sub-instructions that follow are not executed
+#define INSTRUCTION_STATUS_REJECTED    0x4    // Rejected by the instruction handler (e.g. a write instruction executed conditionally)
+
 
 #endif
\ No newline at end of file
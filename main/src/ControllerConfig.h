@@ -29,8 +29,32 @@
 #define IRRIGATION_ZONES_COUNT   3   // Up to 4 (expandable to 8)
 #define IRRIGATION_SOURCES_COUNT 2   // Up to 2
 #define IRRIGATION_GROUPS_COUNT  10  // Subject to EEPROM memory size
+#define IRRIGATION_JOB_QUEUE_LENGTH (IRRIGATION_GROUPS_COUNT + 1)  // Irrigation jobs that can be queued (every group + the manual irrigation, 10 bytes of RAM each)
+#define IRRIGATION_JOB_GROUP_BY_SOURCE 1   // Queue the jobs after the pending jobs of the same source, to start/stop each source once per batch
+#define IRRIGATION_JOB_COALESCING      JOB_COALESCING_MAX  // Merging of the jobs added with the same source as a queued job and a subset of its zones (JOB_COALESCING_*)
+#define IRRIGATION_SOURCE_MAX_ZONES    { 1, 1 }  // Zones that each source can irrigate at once (a job with more zones can still run on its own)
+#define IRRIGATION_CONCURRENT_SOURCES  0   // Allow the sources to irrigate (different zones) at the same time
+#define VALVE_PULSE_QUEUE_LENGTH 8   // Electrovalve pulses that can be queued (5 bytes of RAM each, at least IRRIGATION_ZONES_COUNT)
+
+// Task Scheduler Configuration
+#define TASK_SCHEDULER_MAX_TASKS    4     // Tasks that can be registered in the TaskSchedulerThread
+#define IRRIGATION_TASK_INTERVAL    100   // ms - Run interval of the IrrigationController
+#define SWIMMING_POOL_TASK_INTERVAL 100   // ms - Run interval of the SwimmingPoolController
+#define THREAD_STATISTICS_SLOTS     4     // Loop timing statistics slots (whole pass + threads, 26 bytes of RAM each)
+
+// Power Configuration
+#define IDLE_SLEEP_ENABLED          1     // Sleep (AVR idle mode) between the thread runs
+
+// Time Configuration
+#define TIMEBASE_SYNC_INTERVAL 1000   // ms - Interval between RTC reads (the time is interpolated with millis() in between)
 
 // Communication Configuration
-#define TIMEOUT_PER_PACKET 100       // ms
+#define TIMEOUT_PER_PACKET          100  // ms
+#define COMM_LEGACY_FRAMING_ENABLED 0    // Accept the legacy (parity checked) frames in addition to the CRC-16 frames (opt-in, for older clients)
+                                         // NOTE: legacy frames are not addressed and only parity checked, see CommunicationsThread.h
+#define PLC_NODE_ADDRESS            1    // RS485 node address (1 to 255, unique on the bus)
+#define COMM_RX_QUEUE_LENGTH        4    // Requests that can be received before being handled
+#define COMM_RESPONSE_DELAY         2    // ms - Bus idle time before a response is sent
+#define COMM_STATISTICS_SLOTS       12   // Instructions tracked by the communication statistics (11 bytes of RAM each)
 
 #endif
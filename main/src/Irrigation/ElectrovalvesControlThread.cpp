@@ -8,29 +8,26 @@ const uint16_t PULSE_DURATION           = 100;
 const uint16_t BETWEEN_PULSES_DURATION  = 100;
 const uint16_t BETWEEN_SOURCES_DURATION = 3000;
 
-// Time in us
-const uint16_t MULTIPLEXER_SIGNAL_DELAY = 100;
+const uint8_t SOURCE_MAX_ZONES[IRRIGATION_SOURCES_COUNT] = IRRIGATION_SOURCE_MAX_ZONES;
 
+#define ACTIVE_JOB_STATES (_BV(JOB_STARTING) | _BV(JOB_RUNNING))
 
-ElectrovalvesControlThread::ElectrovalvesControlThread()
-{
-    initialisePins();
 
+static uint8_t countZones(uint16_t zones) {
+    uint8_t count = 0;
+    for (; zones != 0; zones &= zones - 1) count++;
+    return count;
+}
+
+
+ElectrovalvesControlThread::ElectrovalvesControlThread(ChangeTracker*& changeTracker) : changeTracker(changeTracker)
+{
     // IMPORTANT: Make sure all electrovalves are turned off, as the DC latching solenoid valves will remain
     // indefinitely in the 'on' state until an 'off' pulse is sent; after a power loss, any open electrovalve
     // will not close if the reset method is not called.
     reset();
 }
 
-void ElectrovalvesControlThread::initialisePins() {
-    // Multiplexer - Zones
-    pinMode(MULTIPLEXER_SELECT_PIN_0, OUTPUT);
-    pinMode(MULTIPLEXER_SELECT_PIN_1, OUTPUT);
-    pinMode(MULTIPLEXER_SELECT_PIN_2, OUTPUT);
-    pinMode(MULTIPLEXER_SELECT_PIN_3, OUTPUT);
-    pinMode(MULTIPLEXER_SIGNAL_PIN, OUTPUT);
-}
-
 
 
 // Control functions ************************************************************************************************************
@@ -44,24 +41,27 @@ bool ElectrovalvesControlThread::addJob(uint16_t electrovalveIndexes, uint8_t so
     ) return false; //TODO NOTE ERROR?
 
     // Save job
-    JobConfig* newJob = new JobConfig();
+    JobConfig newJob;
+
+    newJob.zones       = electrovalveIndexes;
+    newJob.sourceIndex = sourceIndex;
+    newJob.duration    = duration;
+    newJob.state       = JOB_PENDING;
 
-    newJob->zones           = electrovalveIndexes;
-    newJob->sourceIndex     = sourceIndex;
-    newJob->duration        = duration;
-    newJob->nextPendingZone = -1;
+    if (coalesceJob(newJob)) return true;
 
-    jobQueue.add(newJob);
+    if (!jobQueue.insert(getJobInsertIndex(sourceIndex), newJob)) return false; // Queue full
 
     return true;
 }
 
-void ElectrovalvesControlThread::cancelCurrentJob(){
-    cancelQueue.add(CANCEL_CURRENT_JOB);
+bool ElectrovalvesControlThread::cancelCurrentJob(){
+    return cancelQueue.push(CANCEL_CURRENT_JOB);
 }
 
 void ElectrovalvesControlThread::cancelAllJobs(){
-    cancelQueue.add(CANCEL_ALL_JOBS);
+    // If the queue is full, the last request is replaced, as cancelling all jobs includes it
+    if (!cancelQueue.push(CANCEL_ALL_JOBS)) cancelQueue.back() = CANCEL_ALL_JOBS;
 }
 
 
@@ -79,218 +79,183 @@ bool ElectrovalvesControlThread::checkChanges(){
 }
 
 uint16_t ElectrovalvesControlThread::getValvesState(){
-    return jobQueue.size() == 0 ? 0 : jobQueue.get(0)->zones;
+    return _valvesState;
 }
 
 
 // Thread run function **********************************************************************************************************
 
 void ElectrovalvesControlThread::run() {
-    // If a pulse is being triggered, do nothing else until completed
-    if (_pulseActive) {
-        uint32_t pulseEllapsedTime = millis() - _pulseStartTimestamp;
-        if (pulseEllapsedTime >= PULSE_DURATION) unsetZonePulse();
+    // If pulses are being sent, do nothing else until completed
+    pulseEngine->service();
+    if (pulseEngine->isBusy()) return runned();
 
-        return runned();
-    }
+    processCancelRequests();
+    removeFinishedJobs();
+    startPendingJobs();
+    updateValves();
 
-    // If a cancel request has been triggered
-    if (cancelQueue.size() > 0) {
-        // If starting, transitioning or stopping, wait until complete
-        // If running, force stopping
-        if (_state == ElectrovalvesControlThreadState::RUNNING_JOB) {
-            // Stop current job
-            _state = ElectrovalvesControlThreadState::STOPPING_JOB;
-        }
-        else if (_state == ElectrovalvesControlThreadState::IDLE) {
-            // Once on idle state, cancel job(s)
-            CancelType cancelRequest = cancelQueue.get(0);
-            if (cancelRequest == CANCEL_ALL_JOBS) {
-                // Cancel all jobs
-                removeAllJobsFromQueue();
-                cancelQueue.clear();
-            }
-            else {
-                cancelQueue.remove(0);
-            }
-            return runned();
-        }
-    }
-
-    // Trigger the active state loop function
-    switch (_state) {
-        case ElectrovalvesControlThreadState::IDLE:
-            idleLoop();
-            break;
-        case ElectrovalvesControlThreadState::STARTING_JOB:
-            startingLoop();
-            break;
-        case ElectrovalvesControlThreadState::RUNNING_JOB:
-            runningLoop();
-            break;
-        case ElectrovalvesControlThreadState::TRANS_JOB:
-            transitionLoop();
-            break;
-        case ElectrovalvesControlThreadState::STOPPING_JOB:
-            stoppingLoop();
-            break;
-        default:
-            reset(); // Undefined state
-        break;
-    }
     runned();
 }
 
 
 
-// Loops ************************************************************************************************************************
+// Job functions ****************************************************************************************************************
 
-void ElectrovalvesControlThread::idleLoop() {
-    // Check job queue
-    if (jobQueue.size() > 0) {
-        _state = ElectrovalvesControlThreadState::STARTING_JOB;
-    }
-}
+bool ElectrovalvesControlThread::coalesceJob(const JobConfig& newJob) {
+#if IRRIGATION_JOB_COALESCING != JOB_COALESCING_NONE
+    for (uint8_t i = 0; i < jobQueue.size(); i++) {
+        JobConfig& job = jobQueue.get(i);
 
-void ElectrovalvesControlThread::startingLoop() {
+        // The zones of the new job must all be irrigated by the queued job, and its duration can only be extended if
+        // both jobs have the same zones (otherwise the other zones of the queued job would be irrigated for longer)
+        if (job.sourceIndex != newJob.sourceIndex || (newJob.zones & ~job.zones) != 0) continue;
+        const bool sameZones = newJob.zones == job.zones;
 
-    // Get the job
-    JobConfig* activeJobPtr = jobQueue.get(0);
+#if IRRIGATION_JOB_COALESCING == JOB_COALESCING_MAX
+        // Duration from the start of the job to the end of the new one
+        const uint32_t ellapsedTime = job.state == JOB_RUNNING ? (millis() - job.startTimestamp) / 1000 : 0;
+        const uint32_t newDuration  = ellapsedTime + newJob.duration;
 
-    // First time checks
-    if (activeJobPtr->nextPendingZone == -1) {
-
-        // Wait since last source active
-        const uint32_t ellapsedSinceLastSource = millis() - _sourceEndTimestamp;
-        if (ellapsedSinceLastSource < BETWEEN_SOURCES_DURATION) {
-            return;
+        if (newDuration > job.duration) {
+            if (!sameZones) continue;
+            job.duration = min(newDuration, (uint32_t) 0xFFFF);
         }
-
-        activeJobPtr->nextPendingZone = getNextZone(activeJobPtr->zones, -1);
+#elif IRRIGATION_JOB_COALESCING == JOB_COALESCING_SUM
+        if (!sameZones) continue;
+        job.duration = min((uint32_t) job.duration + newJob.duration, (uint32_t) 0xFFFF);
+#endif
+        return true;
     }
+#endif
 
-    // Turn on zones
-    const bool allZonesTurnedOn = setJobZonesState(activeJobPtr, true);
+    return false;
+}
 
-    // If all zones have been turned on
-    if (allZonesTurnedOn) {
-        // Turn on the source and register the start timestamp
-        turnOnSource(activeJobPtr->sourceIndex);
-        activeJobPtr->startTimestamp = millis();
+void ElectrovalvesControlThread::processCancelRequests() {
+    CancelType cancelRequest;
+    while (cancelQueue.shift(cancelRequest)) {
+        if (jobQueue.isEmpty()) continue;
 
-        // Change job state
-        _state = ElectrovalvesControlThreadState::RUNNING_JOB;
-        changed = true;
-    }
+        if (cancelRequest == CANCEL_ALL_JOBS) jobQueue.clear();
+        else                                  jobQueue.remove(getCurrentJobIndex());
 
+        markJobsChanged();
+    }
 }
 
-void ElectrovalvesControlThread::runningLoop() {
+void ElectrovalvesControlThread::removeFinishedJobs() {
+    uint8_t i = 0;
+    while (i < jobQueue.size()) {
+        JobConfig& job = jobQueue.get(i);
+        const uint32_t ellapsedTime = (millis() - job.startTimestamp) / 1000;  //TODO IMPLEMENT FAILSAFE IN CASE REMAINING TIME IS TOO LONG?
 
-    // If the job duration has been reached, change the job state
-    JobConfig* activeJobPtr = jobQueue.get(0);
-    uint32_t ellapsedTime = (millis() - activeJobPtr->startTimestamp) / 1000;  //TODO IMPLEMENT FAILSAFE IN CASE REMAINING TIME IS TOO LONG?
-    
-    if (ellapsedTime >= activeJobPtr->duration) {
-        // If a next job is set, and it has the same source as the current job, transition
-        if (jobQueue.size() > 1 && activeJobPtr->sourceIndex == jobQueue.get(1)->sourceIndex) {
-            _state = ElectrovalvesControlThreadState::TRANS_JOB;
+        if (job.state == JOB_RUNNING && ellapsedTime >= job.duration) {
+            jobQueue.remove(i);
+            markJobsChanged();
         }
-        else { // Otherwise stop
-            _state = ElectrovalvesControlThreadState::STOPPING_JOB;
+        else {
+            i++;
         }
     }
 }
 
-void ElectrovalvesControlThread::transitionLoop() {
-    switch(_transState) {
-        case TransitionState::TRANS_IDLE:
-            _transState = TransitionState::OPENING_NEXT;
-            // Note that there is intentionally no 'break;' at this point
+void ElectrovalvesControlThread::startPendingJobs() {
+    uint8_t blockedSources = 0;     // Sources with a pending job that cannot be started (the jobs that follow must wait)
 
-        case TransitionState::OPENING_NEXT:
-            trOpenNextJobZones();
-            break;
-
-        case TransitionState::CLOSING_CURRENT:
-            trCloseCurrentJobZones();
-            break;
+    for (uint8_t i = 0; i < jobQueue.size(); i++) {
+        JobConfig& job = jobQueue.get(i);
+        if (job.state != JOB_PENDING || (blockedSources & _BV(job.sourceIndex)) != 0) continue;
 
-        default:
-            reset(); // Undefined state
-            break;
+        if (canStartJob(job)) job.state = JOB_STARTING;
+        else                  blockedSources |= _BV(job.sourceIndex);
     }
 }
 
-void ElectrovalvesControlThread::stoppingLoop() {
+bool ElectrovalvesControlThread::canStartJob(JobConfig& job) {
+    const uint16_t sourceZones = getJobsZones(ACTIVE_JOB_STATES, job.sourceIndex);
+    const uint16_t activeZones = getJobsZones(ACTIVE_JOB_STATES);
 
-    JobConfig* activeJobPtr = jobQueue.get(0);
+    // The zones cannot be irrigated by two sources at once
+    if ((job.zones & (activeZones & ~sourceZones)) != 0) return false;
 
-    // Stop the source
-    if (activeJobPtr->nextPendingZone == -1) {
-        turnOffSource(activeJobPtr->sourceIndex);
-        _sourceEndTimestamp = millis();
-        activeJobPtr->nextPendingZone = getNextZone(activeJobPtr->zones, -1);
-    }
+    if (!getSourceState(job.sourceIndex)) {
+        // Wait since last source active
+        if (millis() - _sourceEndTimestamp < BETWEEN_SOURCES_DURATION) return false;
 
-    const bool allZonesTurnedOff = setJobZonesState(activeJobPtr, false);
-    if (allZonesTurnedOff) {
-        // Remove job from the queue
-        removeCurrentJobFromQueue();
-        // Set thread to idle
-        _state = ElectrovalvesControlThreadState::IDLE;
-        changed = true;
+#if !IRRIGATION_CONCURRENT_SOURCES
+        for (uint8_t i = 0; i < IRRIGATION_SOURCES_COUNT; i++) {
+            if (getSourceState(i)) return false;
+        }
+        if ((activeZones & ~sourceZones) != 0) return false;
+#endif
     }
 
+    // A job that exceeds the source capacity can still run on its own
+    return sourceZones == 0 || countZones(sourceZones | job.zones) <= SOURCE_MAX_ZONES[job.sourceIndex];
 }
 
+void ElectrovalvesControlThread::updateValves() {
+    const uint16_t requiredZones = getJobsZones(ACTIVE_JOB_STATES);
 
+    // Open the zones of the starting jobs (before their source is turned on)
+    if (setZonesState(requiredZones & ~_openZones, true)) return;
 
-// Transition functions *********************************************************************************************************
-
-void ElectrovalvesControlThread::trOpenNextJobZones() {
+    // Start the jobs once their zones are open
+    for (uint8_t i = 0; i < jobQueue.size(); i++) {
+        JobConfig& job = jobQueue.get(i);
+        if (job.state != JOB_STARTING) continue;
 
-    JobConfig* currJobPtr = jobQueue.get(0);
-    JobConfig* nextJobPtr = jobQueue.get(1);
-
-    // Set start condition
-    if (nextJobPtr->nextPendingZone == -1) {
-        nextJobPtr->nextPendingZone = getNextZone(nextJobPtr->zones, -1);
+        if (!getSourceState(job.sourceIndex)) turnOnSource(job.sourceIndex);
+        job.state          = JOB_RUNNING;
+        job.startTimestamp = millis();
+        markJobsChanged();
     }
 
-    // Turn on the zones of the next job ignoring the zones that are already opened by the current job
-    const bool allZonesTurnedOn = setJobZonesState(nextJobPtr, true, currJobPtr->zones);
+    // Turn off the sources without active jobs (before closing their zones)
+    for (uint8_t i = 0; i < IRRIGATION_SOURCES_COUNT; i++) {
+        if (getSourceState(i) && getJobsZones(ACTIVE_JOB_STATES, i) == 0) {
+            turnOffSource(i);
+            _sourceEndTimestamp = millis();
+        }
+    }
+    sourceOutputs.commit();
 
-    // If all zones have been opened
-    if (allZonesTurnedOn) {
-        nextJobPtr->startTimestamp = millis();              // Set the start time
-        _transState = TransitionState::CLOSING_CURRENT;     // Change transition state
-    };
+    // Close the zones that are no longer required (once the zones of the jobs that follow have been opened)
+    setZonesState(_openZones & ~requiredZones, false);
 }
 
-void ElectrovalvesControlThread::trCloseCurrentJobZones() {
+void ElectrovalvesControlThread::markJobsChanged() {
+    _valvesState = getJobsZones(_BV(JOB_RUNNING));
+    changed = true;
+    changeTracker->markChanged(CHANGE_FIELD_IRR_ZONES_STATE);
+}
 
-    JobConfig* currJobPtr = jobQueue.get(0);
-    JobConfig* nextJobPtr = jobQueue.get(1);
+uint16_t ElectrovalvesControlThread::getJobsZones(const uint8_t states, const int8_t sourceIndex /* = -1 */) {
+    uint16_t zones = 0;
+    for (uint8_t i = 0; i < jobQueue.size(); i++) {
+        JobConfig& job = jobQueue.get(i);
+        if ((states & _BV(job.state)) != 0 && (sourceIndex == -1 || job.sourceIndex == sourceIndex)) zones |= job.zones;
+    }
+    return zones;
+}
 
-    // Set start condition
-    if (currJobPtr->nextPendingZone == -1) {
-        currJobPtr->nextPendingZone = getNextZone(currJobPtr->zones, -1);
+uint8_t ElectrovalvesControlThread::getCurrentJobIndex() {
+    for (uint8_t i = 0; i < jobQueue.size(); i++) {
+        if (jobQueue.get(i).state != JOB_PENDING) return i;
     }
+    return 0;
+}
 
-    // Turn off the zones of the current job ignoring the zones that are required by the next job
-    const bool allZonesTurnedOff = setJobZonesState(currJobPtr, false, nextJobPtr->zones);
-    
-    // If all zones have been closed
-    if (allZonesTurnedOff) {
-        // Remove job from the queue
-        removeCurrentJobFromQueue();
-        // Change transition and controller state
-        _transState = TransitionState::TRANS_IDLE;
-        _state      = ElectrovalvesControlThreadState::RUNNING_JOB;
-        changed = true;
-    };
+uint8_t ElectrovalvesControlThread::getJobInsertIndex(const uint8_t sourceIndex) {
+#if IRRIGATION_JOB_GROUP_BY_SOURCE
+    // After the last queued job with the same source
+    for (int8_t i = jobQueue.size() - 1; i >= 0; i--) {
+        if (jobQueue.get(i).sourceIndex == sourceIndex) return i + 1;
+    }
+#endif
 
+    return jobQueue.size();
 }
 
 
@@ -307,140 +272,88 @@ void ElectrovalvesControlThread::turnOffSource(const uint8_t sourceIndex) {
 
 void ElectrovalvesControlThread::setSourceState(const uint8_t sourceIndex, const bool state) {
     switch (sourceIndex) {
-        case 0: state ? mainsWaterInletValve->turnOn() : mainsWaterInletValve->turnOff(); break;
-        case 1: state ? swimmingPoolIrrigationPump->turnOn() : swimmingPoolIrrigationPump->turnOff(); break;
+        case 0:
+            state ? mainsWaterInletValve->turnOn(&sourceOutputs) : mainsWaterInletValve->turnOff(&sourceOutputs);
+            changeTracker->markChanged(CHANGE_FIELD_IRR_MAINS_INLET_STATE);
+            break;
+        case 1:
+            state ? swimmingPoolIrrigationPump->turnOn(&sourceOutputs) : swimmingPoolIrrigationPump->turnOff(&sourceOutputs);
+            changeTracker->markChanged(CHANGE_FIELD_IRR_PUMP_STATE);
+            break;
     }
 }
 
-
-
-// Irrigation zones functions ***************************************************************************************************
-
-bool ElectrovalvesControlThread::setJobZonesState(JobConfig* config, const bool state, uint16_t ignoreZones /* = 0 */) {
-
-    uint16_t zones           = config->zones;
-    int8_t   nextPendingZone = config->nextPendingZone;
-
-    if (nextPendingZone == IRRIGATION_ZONES_COUNT) {  // This check is here and not at the end of the function to ensure the electrovalve pulse has completed before modifying the source state
-        config->nextPendingZone = -1;
-        return true; // Job completed
-    }
-
-    // Get the time since the last turn on pulse
-    uint32_t timeSinceLastPulseStart = millis() - _pulseStartTimestamp;
-
-    // Start a new pulse once BETWEEN_PULSES_DURATION ms has ellapsed
-    if (timeSinceLastPulseStart >= PULSE_DURATION + BETWEEN_PULSES_DURATION) {
-        // If the zone index is not in the ignore zones variable, send pulse
-        if ((ignoreZones & (1 << nextPendingZone)) == 0) { 
-            if (state) turnOnZone(nextPendingZone);
-            else       turnOffZone(nextPendingZone);
-        }
-
-        config->nextPendingZone = getNextZone(zones, nextPendingZone);
+bool ElectrovalvesControlThread::getSourceState(const uint8_t sourceIndex) {
+    switch (sourceIndex) {
+        case 0:
+            return mainsWaterInletValve->getState();
+        case 1:
+            return swimmingPoolIrrigationPump->getState();
+        default:
+            return false;
     }
-
-    return false;
 }
 
 
-int8_t ElectrovalvesControlThread::getNextZone(uint16_t selectedZones, int8_t currentZoneIndex) {
-    // Return the index of the next selected zone
 
-    // The zones configuration (selectedZones) represents which zones are requested by setting the bits corresponding to 
-    // the zones indexes to 1: the ith zone is selected if the ith bit of selectedZones is a 1.
-    do {
-        currentZoneIndex++;
-    } while(currentZoneIndex < IRRIGATION_ZONES_COUNT && ((1 << currentZoneIndex) & selectedZones) == 0);
+// Irrigation zones functions ***************************************************************************************************
 
-    return currentZoneIndex;
-}
+bool ElectrovalvesControlThread::setZonesState(const uint16_t zones, const bool state) {
+    // Queue the pulses of all the zones (the pulse engine spaces them BETWEEN_PULSES_DURATION ms apart)
+    bool pulsesQueued = false;
 
-void ElectrovalvesControlThread::turnOnZone(const uint8_t zoneIndex) {
-    setZonePulse(2 * zoneIndex);
-}
+    for (uint8_t i = 0; i < IRRIGATION_ZONES_COUNT; i++) {
+        if ((zones & _BV(i)) == 0) continue;
 
-void ElectrovalvesControlThread::turnOffZone(const uint8_t zoneIndex) {
-    setZonePulse(2 * zoneIndex + 1);
-}
+        const bool queued = state ? turnOnZone(i) : turnOffZone(i);
+        if (!queued) break;   // Queue full, retry on the next run
 
-void ElectrovalvesControlThread::setZonePulse(const uint8_t pulseOutputIndex) {
-    setMultInputPins(pulseOutputIndex);             // Set multiplexer address
-    delayMicroseconds(MULTIPLEXER_SIGNAL_DELAY);    // Wait for multiplexer to be set
-    setMultSignalState(true);                       // Set signal high
+        if (state) _openZones |= _BV(i);
+        else       _openZones &= ~_BV(i);
+        pulsesQueued = true;
+    }
 
-    // Save pulse info
-    _pulseActive = true;
-    _pulseStartTimestamp = millis();
+    return pulsesQueued;
 }
 
-void ElectrovalvesControlThread::unsetZonePulse() {
-    setMultSignalState(false);  // Set signal low
-    _pulseActive = false;       // Reset pulse info
+bool ElectrovalvesControlThread::turnOnZone(const uint8_t zoneIndex) {
+    return setZonePulse(2 * zoneIndex);
 }
 
-// Set the address of the multiplexer
-void ElectrovalvesControlThread::setMultInputPins(const uint8_t inputIndex) {
-    digitalWrite(MULTIPLEXER_SELECT_PIN_0, (inputIndex & 1) != 0);
-    digitalWrite(MULTIPLEXER_SELECT_PIN_1, (inputIndex & 2) != 0);
-    digitalWrite(MULTIPLEXER_SELECT_PIN_2, (inputIndex & 4) != 0);
-    digitalWrite(MULTIPLEXER_SELECT_PIN_3, (inputIndex & 8) != 0);
+bool ElectrovalvesControlThread::turnOffZone(const uint8_t zoneIndex) {
+    return setZonePulse(2 * zoneIndex + 1);
 }
 
-// Set the state of the signal going into the multiplexer
-void ElectrovalvesControlThread::setMultSignalState(const bool state) {
-    digitalWrite(MULTIPLEXER_SIGNAL_PIN, state);
+bool ElectrovalvesControlThread::setZonePulse(const uint8_t pulseOutputIndex) {
+    return pulseEngine->enqueue(pulseOutputIndex, PULSE_DURATION, BETWEEN_PULSES_DURATION);
 }
 
 
 
-// Reset/Cancel functions *******************************************************************************************************
+// Reset functions **************************************************************************************************************
 
 void ElectrovalvesControlThread::reset() {
 
-    // Turn of multiplexer signal
-    setMultSignalState(false);
-    _pulseActive = false;
+    // Drop any pending pulse (turns off the multiplexer signal)
+    pulseEngine->cancel();
 
     // Reset state variables
-    _state = ElectrovalvesControlThreadState::IDLE;
-    _transState = TransitionState::TRANS_IDLE;
-    _pulseStartTimestamp = millis();
-    _sourceEndTimestamp  = millis();
+    _sourceEndTimestamp = millis();
+    _openZones          = 0;
 
     // Turn off all sources
     for (uint8_t i = 0; i < IRRIGATION_SOURCES_COUNT; i++) {
         turnOffSource(i);
     }
+    sourceOutputs.commit();
 
-    // Turn off all zones
+    // Turn off all zones (the pulses are sent in the background, and the thread does not run until they are completed)
     for (uint8_t i = 0; i < IRRIGATION_ZONES_COUNT; i++) {
         turnOffZone(i);
-        // IMPORTANT - WAIT PULSE_DURATION AND DISABLE THE PULSE MANUALLY, AS THE RUN THREAD FUNCTION IS NOT BEING CALLED
-        delay(PULSE_DURATION);
-        unsetZonePulse();
-        delay(BETWEEN_PULSES_DURATION);
     }
 
     // Clear queues
-    while (jobQueue.size() > 0) {
-        JobConfig* jobPtr = jobQueue.get(0);
-        delete jobPtr;
-        jobQueue.remove(0);
-    }
-
+    jobQueue.clear();
     cancelQueue.clear();
+    _valvesState = 0;
 }
-
-void ElectrovalvesControlThread::removeCurrentJobFromQueue() {
-    JobConfig* currJobPtr = jobQueue.get(0);
-    delete currJobPtr;
-    jobQueue.remove(0);
-}
-
-void ElectrovalvesControlThread::removeAllJobsFromQueue() {
-    // TODO Make sure in idle state?
-    while (jobQueue.size() != 0) {
-        removeCurrentJobFromQueue();
-    }
-}
\ No newline at end of file
@@ -5,22 +5,35 @@
   - The sources are enabled via the controller's output relays.
   - The irrigation zones are controlled by turning on/off the DC latching-solenoid electrovalves via a multiplexer.
 
-  As multiple irrigation job requests can be triggered at the same time, these are stored in a 'jobQueue'.
-
-  1. When a job is received, the controller will go into the 'startingLoop', which will enable the sources and irrigation
-  zones of that job (the irrigation zones are always enabled/disabled one at a time, according to the turn on/off pulse parameters).
-
-  2. Once everything is set, the controller will go into the 'runningLoop', which will wait for the duration of the job
-  to ellapse.
-
-  3. Once the job finishes, if there is another job pending with the same irrigation source, the controller will go into the
-  'transitionLoop', which will update the irrigation zones without disabling the irrigation source and then go back to the 
-  'runningLoop'. Otherwise, the controller goes into the 'stoppingLoop', which will disable the active irrigation zones and source.
-
-  The 'loop' functions are called everytime the 'run' method of this thread is called. However, if a pulse is being triggered,
-  the pulse control logic will take precedence over the active 'loop'.
+  As multiple irrigation job requests can be triggered at the same time, these are stored in a 'jobQueue' (statically allocated,
+  up to IRRIGATION_JOB_QUEUE_LENGTH jobs; 'addJob' returns false if the queue is full).
+  If IRRIGATION_JOB_GROUP_BY_SOURCE is set, a new job is queued right after the last pending job with the same source instead
+  of at the back of the queue, so that the jobs of each source are kept together.
+  Unless IRRIGATION_JOB_COALESCING is JOB_COALESCING_NONE, a new job with the same source as a queued job and a subset of its
+  zones is merged into it instead of being queued (saving the valve pulses and running the zones once), e.g. a group that
+  becomes due whilst a manual run of the same group is queued. The duration of the queued job becomes the longest of both
+  (JOB_COALESCING_MAX, counting the new duration from the moment it is added if the job has already been started), their
+  sum (JOB_COALESCING_SUM) or is kept (JOB_COALESCING_DROP, i.e. the duplicate is dropped). The duration is only extended
+  if both jobs have the same zones, so that the other zones of the queued job are not irrigated for longer: otherwise the
+  new job is queued as usual.
+
+  Several jobs can run at the same time, within the hydraulic capacity of their sources:
+  1. On every run, the pending jobs are started in queue order (keeping the order of the jobs of each source) as long as:
+    - The zones of the job are not being irrigated by another source.
+    - The zones being irrigated by the source, including the ones of the job, do not exceed IRRIGATION_SOURCE_MAX_ZONES
+    (a job with more zones than the source capacity can still run on its own).
+    - If the source is off, BETWEEN_SOURCES_DURATION has ellapsed since a source was last turned off, and no other source
+    is on unless IRRIGATION_CONCURRENT_SOURCES is set.
+
+  2. The zones of the starting jobs are opened, and then their sources are turned on and their duration starts counting.
+
+  3. Once the duration of a job ellapses it is removed from the queue, and its zones are closed once the zones of the jobs
+  that follow have been opened (so that a source is never left running without open zones, and is not stopped between
+  back to back jobs). The sources without running jobs are turned off before closing their zones.
 
   Note that to turn on/off the electrovalve i, a pulse is sent via the multiplexer's output 2*i / 2*i+1 respectively.
+  The pulses are not timed by this thread: the pulses of all the zones to update are queued at once in the ValvePulseEngine,
+  which sends them from a timer interrupt, and the thread does nothing else until they are completed.
   
 */
 #ifndef ElectrovalvesControlThread_h
@@ -28,46 +41,45 @@
 
 #include <Arduino.h>
 #include <Thread.h>
-#include <LinkedList.h>
 
 #include "../ControllerConfig.h"
 #include "../Utils/InterfaceUtils.h"
+#include "../Utils/ChangeTracker.h"
+#include "../Utils/RingBuffer.h"
+#include "ValvePulseEngine.h"
+
 
+#define JOB_COALESCING_NONE 0
+#define JOB_COALESCING_MAX  1
+#define JOB_COALESCING_SUM  2
+#define JOB_COALESCING_DROP 3
 
 enum CancelType {
-    CANCEL_CURRENT_JOB = 0,
+    CANCEL_CURRENT_JOB = 0,     // The first started job (or the first pending one if none has been started)
     CANCEL_ALL_JOBS
 };
 
-enum ElectrovalvesControlThreadState {
-    IDLE = 0,
-    STARTING_JOB,
-    RUNNING_JOB,
-    TRANS_JOB,
-    STOPPING_JOB
-};
-
-enum TransitionState {
-    TRANS_IDLE = 0,
-    OPENING_NEXT,
-    CLOSING_CURRENT
+enum JobState : uint8_t {
+    JOB_PENDING = 0,
+    JOB_STARTING,   // Opening its zones
+    JOB_RUNNING
 };
 
 struct JobConfig {
     uint16_t zones;
     uint8_t  sourceIndex;
     uint16_t duration;
-    int8_t   nextPendingZone;
+    JobState state;
     uint32_t startTimestamp;
 };
 
 class ElectrovalvesControlThread: public Thread
 {
     public:
-        ElectrovalvesControlThread();
+        ElectrovalvesControlThread(ChangeTracker*& changeTracker);
 
         bool addJob(uint16_t electrovalveIndexes, uint8_t sourceIndex, uint16_t duration);
-        void cancelCurrentJob();
+        bool cancelCurrentJob();    // Returns false if the cancel queue is full
         void cancelAllJobs();
 
         bool     isBusy();
@@ -80,52 +92,48 @@ class ElectrovalvesControlThread: public Thread
         OutputRelay* swimmingPoolIrrigationPump = new OutputRelay(SWIMMING_POOL_IRRIGATION_PUMP_PIN);
     
     private:
-        LinkedList<JobConfig*> jobQueue    = LinkedList<JobConfig*>();
-        LinkedList<CancelType> cancelQueue = LinkedList<CancelType>();
+        ChangeTracker*& changeTracker;
+
+        ValvePulseEngine* pulseEngine = new ValvePulseEngine();
+        OutputBatch       sourceOutputs;    // Source relay changes, committed at once before any zone is closed
 
-        ElectrovalvesControlThreadState _state;
+        RingBuffer<JobConfig, IRRIGATION_JOB_QUEUE_LENGTH>  jobQueue;
+        RingBuffer<CancelType, IRRIGATION_JOB_QUEUE_LENGTH> cancelQueue;
 
-        bool     _pulseActive;
-        uint32_t _pulseStartTimestamp;
+        uint16_t _openZones   = 0;  // Zones whose turn on pulse has been sent
+        uint16_t _valvesState = 0;  // Zones of the running jobs
 
         uint32_t _sourceEndTimestamp;
 
         bool changed = false;   // Flag that indicates whether the state of the valves/sources has changed
 
-        TransitionState _transState;
-
-        void initialisePins();
+        // Job functions
+        bool coalesceJob(const JobConfig& newJob);     // Returns true if merged into a queued job
+        void processCancelRequests();
+        void removeFinishedJobs();
+        void startPendingJobs();
+        bool canStartJob(JobConfig& job);
+        void updateValves();
+        void markJobsChanged();
 
-        // Main loops
-        void idleLoop();
-        void startingLoop();
-        void runningLoop();
-        void transitionLoop();
-        void stoppingLoop();
-
-        // Transition functions
-        void trOpenNextJobZones();
-        void trCloseCurrentJobZones();
+        uint16_t getJobsZones(const uint8_t states, const int8_t sourceIndex = -1);  // Zones of the jobs in 'states' (JobState bitmask), optionally of a single source
+        uint8_t  getCurrentJobIndex();
+        uint8_t  getJobInsertIndex(const uint8_t sourceIndex);
 
         // Source functions
         void turnOnSource(const uint8_t sourceIndex);
         void turnOffSource(const uint8_t sourceIndex);
         void setSourceState(const uint8_t sourceIndex, const bool state);
+        bool getSourceState(const uint8_t sourceIndex);
 
         // Irrigation zones functions
-        bool setJobZonesState(JobConfig* config, const bool state, uint16_t ignoreZones = 0);
-        int8_t getNextZone(uint16_t selectedZones, int8_t currentZoneIndex);
-        void turnOnZone(const uint8_t zoneIndex);
-        void turnOffZone(const uint8_t zoneIndex);
-        void setZonePulse(const uint8_t pulseOutputIndex);
-        void unsetZonePulse();
-        void setMultInputPins(const uint8_t inputIndex);
-        void setMultSignalState(const bool state);
-
-        // Reset/Cancel functions
+        bool setZonesState(const uint16_t zones, const bool state);     // Returns true if any pulse has been queued
+        bool turnOnZone(const uint8_t zoneIndex);
+        bool turnOffZone(const uint8_t zoneIndex);
+        bool setZonePulse(const uint8_t pulseOutputIndex);
+
+        // Reset functions
         void reset();
-        void removeCurrentJobFromQueue();
-        void removeAllJobsFromQueue();
 
 };
 
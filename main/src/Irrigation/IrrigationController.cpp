@@ -10,9 +10,11 @@
 IrrigationController::IrrigationController(
   ElectrovalvesControlThread*& valvesControllerPtr,
   DataSaver*&                  dataSaver,
-  RTC_DS3231 &                 rtcClock
-) : dataSaver(dataSaver), valvesController(valvesControllerPtr), clock(rtcClock)
+  ChangeTracker*&              changeTracker,
+  Timebase*&                   timebase
+) : valvesController(valvesControllerPtr), dataSaver(dataSaver), changeTracker(changeTracker), timebase(timebase)
 {
+  setTaskInterval(IRRIGATION_TASK_INTERVAL);
   loadData();
 }
 
@@ -24,6 +26,9 @@ void IrrigationController::resetIrrigationManualConfig() {
   irrigationManualConfig.zones = 0;
   irrigationManualConfig.sourceIndex = 0;
   saveIrrigationManualConfig();
+
+  changeTracker->markChanged(CHANGE_FIELD_IRR_MANUAL_ZONES);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_MANUAL_SOURCE);
 }
 
 void IrrigationController::resetGroup(uint8_t groupIdx) {
@@ -38,6 +43,9 @@ void IrrigationController::resetGroup(uint8_t groupIdx) {
 
   memset(irrigationGroups[groupIdx].name, 0, IRRIGATION_GROUP_NAME_LENGTH);
   saveIrrigationGroup(groupIdx);
+
+  markGroupChanged(groupIdx);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_GROUPS_STATE);
 }
 
 void IrrigationController::reset() {
@@ -48,6 +56,10 @@ void IrrigationController::reset() {
   irrigationScheduleConfig.maxScheduledDuration = 30*60;
   saveIrrigationScheduleConfig();
 
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_ENABLE);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_PAUSED_STATE);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_RESUME_TIME);
+
   resetIrrigationManualConfig();
 
   for (uint8_t i = 0; i < IRRIGATION_GROUPS_COUNT; i++) {
@@ -55,12 +67,32 @@ void IrrigationController::reset() {
   }
 }
 
+void IrrigationController::reload() {
+  loadData();
+  lastChangeTimestamp++;
+
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_ENABLE);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_PAUSED_STATE);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_RESUME_TIME);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_MANUAL_ZONES);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_MANUAL_SOURCE);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_GROUPS_STATE);
+
+  for (uint8_t i = 0; i < IRRIGATION_GROUPS_COUNT; i++) {
+    markGroupChanged(i);
+  }
+}
+
 
 
 // Controller Loops *************************************************************************************************************
 
 void IrrigationController::runTask(const PLCState& plcState) {
 
+  // Track input changes
+  changeTracker->trackValue(CHANGE_FIELD_IRR_MANUAL_VALUE,          manualIrrigationEnable->value());
+  changeTracker->trackValue(CHANGE_FIELD_IRR_PRESSURE_SENSOR_VALUE, irrigationPressureSensor->value());
+
   switch(state) {
     case IrrigationControllerState::IDLE:
       idleLoop(plcState);
@@ -92,8 +124,8 @@ void IrrigationController::idleLoop(const PLCState& plcState) {
         0xFFFF // Manual irrigation will run 2^16 seconds unless manually disabled //TODO decrease time?
       );
 
-      if (!success) manualIrrigationDisableLock = true;   // Disable manual irrigation if the job failed to prevent an infinite loop (e.g. the manual zones configuration is invalid)
-      else state = IrrigationControllerState::MANUAL_JOB;
+      if (!success) setManualIrrigationDisableLock(true);   // Disable manual irrigation if the job failed to prevent an infinite loop (e.g. the manual zones configuration is invalid)
+      else setState(IrrigationControllerState::MANUAL_JOB);
 
       return;
     }
@@ -103,91 +135,14 @@ void IrrigationController::idleLoop(const PLCState& plcState) {
   else {
     // If manual irrigation is disabled, and the manual switch is turned off, re-enable the manual irrigation
     if (manualIrrigationDisableLock) {
-      manualIrrigationDisableLock = false;
+      setManualIrrigationDisableLock(false);
       lastChangeTimestamp = plcState.time;
     }
   }
 
   // If auto mode is enabled
   if (plcState.autoModeState) {
-
-    // Check the manual schedule queue - that is, jobs that have been manually scheduled via the PLC communication API
-    if (manualScheduleQueue.size() > 0) {
-      const uint8_t groupIdx = manualScheduleQueue.shift();
-      if (groupIdx < IRRIGATION_GROUPS_COUNT) {
-        IrrigationGroup& irrGroup = irrigationGroups[groupIdx];
-        if (
-          (irrGroup.duration < irrigationScheduleConfig.maxScheduledDuration) &&
-          (irrGroup.duration > irrigationScheduleConfig.minScheduledDuration)
-        ) {
-          valvesController->addJob(
-            irrGroup.zones,
-            irrGroup.source,
-            irrGroup.duration
-          );
-          state = IrrigationControllerState::SCHEDULED_JOB;
-        }
-      }
-      return;
-    }
-
-    // Check the scheduled irrigation (if it is enabled)
-    if (irrigationScheduleConfig.state) {
-
-      // Check if the schedule is paused
-      if (irrigationScheduleConfig.disabledUntilTimestamp != 0) {
-        if (plcState.time < irrigationScheduleConfig.disabledUntilTimestamp) return;
-        else {
-          // Resume time reached
-          irrigationScheduleConfig.disabledUntilTimestamp = 0;
-          saveIrrigationScheduleConfig();
-          lastChangeTimestamp = plcState.time;
-        }
-      }
-
-      // Loop through irrigation groups
-      for (uint8_t i = 0; i < IRRIGATION_GROUPS_COUNT; i++) {
-
-        IrrigationGroup& irrGroup = irrigationGroups[i];
-
-        // Check if disabled
-        if (!irrGroup.enabled) continue;
-
-        // Check if timestamp has been reached
-        if (irrGroup.nextTimestamp <= plcState.time) {
-
-          bool scheduleMissed = plcState.time - irrGroup.nextTimestamp >= irrigationScheduleConfig.maxScheduledTurnOnTimeout;
-
-          if (
-            !scheduleMissed &&
-            (irrGroup.duration < irrigationScheduleConfig.maxScheduledDuration) &&
-            (irrGroup.duration > irrigationScheduleConfig.minScheduledDuration)
-          ) {
-            valvesController->addJob(
-              irrGroup.zones,
-              irrGroup.source,
-              irrGroup.duration
-            );
-            state = IrrigationControllerState::SCHEDULED_JOB;
-          }
-
-          // Update nextTimestamp
-          const uint32_t periodSeconds = (
-            (uint32_t) min((irrGroup.period == 0 ? 24 : irrGroup.period), scheduleMissed ? 24 : 0xFFFFFFFF) // If the schedule was missed, set the period to max 24h (ensure irrigation before the next day)
-          ) * 60 * 60;
-
-          const uint32_t currentTimestamp = irrGroup.nextTimestamp;
-          const uint32_t steps            = floor( (plcState.time - currentTimestamp) / ((float) periodSeconds) ) + 1;
-
-          irrGroup.nextTimestamp = currentTimestamp + steps * periodSeconds;
-
-          saveIrrigationGroup(i);
-
-          lastChangeTimestamp = plcState.time;
-        }
-
-      }
-    }
+    addScheduledJobs(plcState);
   }
   else {
     // If auto mode is not enabled in the control panel, clear the manual schedule queue (prevent jobs from being
@@ -199,7 +154,7 @@ void IrrigationController::idleLoop(const PLCState& plcState) {
 void IrrigationController::manualLoop(const PLCState& plcState) {
   if (!manualIrrigationEnable->value() || !valvesController->isBusy()) {
     valvesController->cancelCurrentJob();
-    state = IrrigationControllerState::IDLE;
+    setState(IrrigationControllerState::IDLE);
     lastChangeTimestamp = plcState.time;
   }
 }
@@ -207,25 +162,89 @@ void IrrigationController::manualLoop(const PLCState& plcState) {
 void IrrigationController::scheduledLoop(const PLCState& plcState) {
   // Lock manual irrigation if it is switched on whilst a scheduled irrigation is active.
   if (manualIrrigationEnable->value() && !manualIrrigationDisableLock) {
-    manualIrrigationDisableLock = true;
+    setManualIrrigationDisableLock(true);
     lastChangeTimestamp = plcState.time;
   }
   else if (!manualIrrigationEnable->value() && manualIrrigationDisableLock) {
-    manualIrrigationDisableLock = false;
+    setManualIrrigationDisableLock(false);
     lastChangeTimestamp = plcState.time;
   }
   
   // Change state to idle if either the scheduled irrigation completes or auto mode gets disabled
-  if (!valvesController->isBusy()) state = IrrigationControllerState::IDLE;
+  if (!valvesController->isBusy()) setState(IrrigationControllerState::IDLE);
   else if (!plcState.autoModeState) {
     valvesController->cancelAllJobs();
-    state = IrrigationControllerState::IDLE;
+    setState(IrrigationControllerState::IDLE);
+  }
+  else {
+    // Keep queueing the due groups, so that they can run alongside (or be coalesced with) the active jobs
+    addScheduledJobs(plcState);
   }
 
   // TODO add irrigation pressure sensor safety cut-off? (as in swimming pool controller)
 
 }
 
+// Adds the jobs of the manually scheduled groups and of the due groups to the job queue (auto mode only)
+void IrrigationController::addScheduledJobs(const PLCState& plcState) {
+  // Check the manual schedule queue - that is, jobs that have been manually scheduled via the PLC communication API
+  uint8_t groupIdx;
+  while (manualScheduleQueue.shift(groupIdx)) {
+    if (groupIdx >= IRRIGATION_GROUPS_COUNT) continue;
+
+    IrrigationGroup& irrGroup = irrigationGroups[groupIdx];
+    if (isDurationValid(irrGroup.duration)) {
+      if (addGroupJob(irrGroup)) setState(IrrigationControllerState::SCHEDULED_JOB);
+    }
+  }
+
+  // Check the scheduled irrigation (if it is enabled)
+  if (irrigationScheduleConfig.state) {
+
+    // Check if the schedule is paused
+    if (irrigationScheduleConfig.disabledUntilTimestamp != 0) {
+      if (plcState.time < irrigationScheduleConfig.disabledUntilTimestamp) return;
+      else {
+        // Resume time reached
+        irrigationScheduleConfig.disabledUntilTimestamp = 0;
+        saveIrrigationScheduleConfig();
+        changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_PAUSED_STATE);
+        changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_RESUME_TIME);
+        lastChangeTimestamp = plcState.time;
+      }
+    }
+
+    // Loop through the due irrigation groups (the deadline index only holds the enabled groups, and each group is 
+    // moved to its next deadline once handled)
+    while (!groupDeadlines.isEmpty() && groupDeadlines.getFirstDeadline() <= plcState.time) {
+
+      const uint8_t i = groupDeadlines.getFirst();
+      IrrigationGroup& irrGroup = irrigationGroups[i];
+
+      bool scheduleMissed = plcState.time - irrGroup.nextTimestamp >= irrigationScheduleConfig.maxScheduledTurnOnTimeout;
+
+      if (!scheduleMissed && isDurationValid(irrGroup.duration)) {
+        if (addGroupJob(irrGroup)) setState(IrrigationControllerState::SCHEDULED_JOB);
+      }
+
+      // Update nextTimestamp
+      const uint32_t periodSeconds = (
+        (uint32_t) min((irrGroup.period == 0 ? 24 : irrGroup.period), scheduleMissed ? 24 : 0xFFFFFFFF) // If the schedule was missed, set the period to max 24h (ensure irrigation before the next day)
+      ) * 60 * 60;
+
+      const uint32_t currentTimestamp = irrGroup.nextTimestamp;
+      const uint32_t steps            = floor( (plcState.time - currentTimestamp) / ((float) periodSeconds) ) + 1;
+
+      irrGroup.nextTimestamp = currentTimestamp + steps * periodSeconds;
+
+      saveIrrigationGroup(i);
+
+      markGroupChanged(i);
+      lastChangeTimestamp = plcState.time;
+    }
+  }
+}
+
 
 // Controller State Methods *****************************************************************************************************
 
@@ -256,6 +275,7 @@ uint16_t IrrigationController::getIrrigationManualZones() {
 void IrrigationController::setIrrigationManualZones(uint16_t zones) {
   irrigationManualConfig.zones = zones;
   lastChangeTimestamp++;
+  changeTracker->markChanged(CHANGE_FIELD_IRR_MANUAL_ZONES);
   saveIrrigationManualConfig();
 }
 
@@ -267,6 +287,7 @@ uint8_t IrrigationController::getIrrigationManualSource() {
 void IrrigationController::setIrrigationManualSource(uint8_t sourceIndex) {
   irrigationManualConfig.sourceIndex = sourceIndex;
   lastChangeTimestamp++;
+  changeTracker->markChanged(CHANGE_FIELD_IRR_MANUAL_SOURCE);
   saveIrrigationManualConfig();
 }
 
@@ -277,12 +298,16 @@ void IrrigationController::setIrrigationManualSource(uint8_t sourceIndex) {
 void IrrigationController::enableSchedule() {
   irrigationScheduleConfig.state = true;
   lastChangeTimestamp++;
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_ENABLE);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_NEXT_IRRIGATION_TIME);
   saveIrrigationScheduleConfig();
 }
 
 void IrrigationController::disableSchedule() {
   irrigationScheduleConfig.state = false;
   lastChangeTimestamp++;
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_ENABLE);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_NEXT_IRRIGATION_TIME);
   saveIrrigationScheduleConfig();
 }
 
@@ -303,24 +328,22 @@ void IrrigationController::pauseSchedule(uint32_t resumeTimestamp) {
   irrigationScheduleConfig.disabledUntilTimestamp = resumeTimestamp;
   saveIrrigationScheduleConfig();
   lastChangeTimestamp++;
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_PAUSED_STATE);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_RESUME_TIME);
 }
 
 void IrrigationController::resumeSchedule() {
   irrigationScheduleConfig.disabledUntilTimestamp = 0;
   saveIrrigationScheduleConfig();
   lastChangeTimestamp++;
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_PAUSED_STATE);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_RESUME_TIME);
 }
 
 uint32_t IrrigationController::getNextIrrigationTime() {
-  uint32_t nextTimestamp = 0xFFFFFFFF;
-  if (!isScheduleEnabled()) return nextTimestamp;
+  if (!isScheduleEnabled()) return DEADLINE_INDEX_NONE;
   // TODO correct timestamp if irrigation is paused
-  for (uint8_t i = 0; i < IRRIGATION_GROUPS_COUNT; i++) {
-    if (isGroupEnabled(i)) {
-      if (irrigationGroups[i].nextTimestamp < nextTimestamp) nextTimestamp = irrigationGroups[i].nextTimestamp;
-    }
-  }
-  return nextTimestamp;
+  return groupDeadlines.getFirstDeadline();
 }
 
 
@@ -333,6 +356,8 @@ void IrrigationController::enableGroup(uint8_t groupIdx) {
 
   irrigationGroups[groupIdx].enabled = true;
   lastChangeTimestamp++;
+  markGroupChanged(groupIdx);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_GROUPS_STATE);
   saveIrrigationGroup(groupIdx);
 }
         
@@ -341,6 +366,8 @@ void IrrigationController::disableGroup(uint8_t groupIdx) {
 
   irrigationGroups[groupIdx].enabled = false;
   lastChangeTimestamp++;
+  markGroupChanged(groupIdx);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_GROUPS_STATE);
   saveIrrigationGroup(groupIdx);  
 }
         
@@ -363,13 +390,13 @@ uint16_t IrrigationController::getGroupsEnableState() {
 void IrrigationController::getGroupName(uint8_t groupIdx, IrrigationGroupName& groupName) {
   if (groupIdx >= IRRIGATION_GROUPS_COUNT) return; // TODO NOTE ERROR?
   memcpy(groupName, &(irrigationGroups[groupIdx].name), IRRIGATION_GROUP_NAME_LENGTH);
-  saveIrrigationGroup(groupIdx);
 }
 
 void IrrigationController::setGroupName(uint8_t groupIdx, IrrigationGroupName& groupName) {
   if (groupIdx >= IRRIGATION_GROUPS_COUNT) return; // TODO NOTE ERROR?
   memcpy(&(irrigationGroups[groupIdx].name), groupName, IRRIGATION_GROUP_NAME_LENGTH);
   lastChangeTimestamp++;
+  markGroupChanged(groupIdx);
   saveIrrigationGroup(groupIdx);
 }
         
@@ -382,10 +409,12 @@ void IrrigationController::setGroupZones(uint8_t groupIdx, uint16_t zones) {
   if (groupIdx >= IRRIGATION_GROUPS_COUNT) return; // TODO NOTE ERROR?
   irrigationGroups[groupIdx].zones = zones;
   lastChangeTimestamp++;
+  markGroupChanged(groupIdx);
   saveIrrigationGroup(groupIdx);
 }
         
 uint8_t IrrigationController::getGroupSource(uint8_t groupIdx) {
+  if (groupIdx >= IRRIGATION_GROUPS_COUNT) return 0; // TODO NOTE ERROR?
   return irrigationGroups[groupIdx].source;
 }
 
@@ -393,44 +422,55 @@ void IrrigationController::setGroupSource(uint8_t groupIdx, uint8_t sourceIdx) {
   if (groupIdx >= IRRIGATION_GROUPS_COUNT) return; // TODO NOTE ERROR?
   irrigationGroups[groupIdx].source = sourceIdx;
   lastChangeTimestamp++;
+  markGroupChanged(groupIdx);
   saveIrrigationGroup(groupIdx);
 }
         
 uint8_t IrrigationController::getGroupPeriod(uint8_t groupIdx) {
+  if (groupIdx >= IRRIGATION_GROUPS_COUNT) return 0; // TODO NOTE ERROR?
   return irrigationGroups[groupIdx].period;
 }
 
 void IrrigationController::setGroupPeriod(uint8_t groupIdx, uint8_t period) {
+  if (groupIdx >= IRRIGATION_GROUPS_COUNT) return; // TODO NOTE ERROR?
   if (!isPeriodValid(period)) return; //TODO note error?
   irrigationGroups[groupIdx].period = period;
   updateNextIrrigationTime(groupIdx);
   lastChangeTimestamp++;
+  markGroupChanged(groupIdx);
   saveIrrigationGroup(groupIdx);
 }
         
 uint16_t IrrigationController::getGroupDuration(uint8_t groupIdx) {
+  if (groupIdx >= IRRIGATION_GROUPS_COUNT) return 0; // TODO NOTE ERROR?
   return irrigationGroups[groupIdx].duration;
 }
 
 void IrrigationController::setGroupDuration(uint8_t groupIdx, uint16_t duration) {
-  if (duration < irrigationScheduleConfig.minScheduledDuration) return;
+  if (groupIdx >= IRRIGATION_GROUPS_COUNT) return; // TODO NOTE ERROR?
+  if (!isDurationValid(duration)) return;
   irrigationGroups[groupIdx].duration = duration;
   lastChangeTimestamp++;
+  markGroupChanged(groupIdx);
   saveIrrigationGroup(groupIdx);
 }
         
 uint16_t IrrigationController::getGroupInitTime(uint8_t groupIdx) {
+  if (groupIdx >= IRRIGATION_GROUPS_COUNT) return 0; // TODO NOTE ERROR?
   return irrigationGroups[groupIdx].time;
 }
 
 void IrrigationController::setGroupInitTime(uint8_t groupIdx, uint16_t time) {
+  if (groupIdx >= IRRIGATION_GROUPS_COUNT) return; // TODO NOTE ERROR?
   irrigationGroups[groupIdx].time = time;
   updateNextIrrigationTime(groupIdx);
   lastChangeTimestamp++;
+  markGroupChanged(groupIdx);
   saveIrrigationGroup(groupIdx);
 }
 
 uint32_t IrrigationController::getGroupNextIrrigationTime(uint8_t groupIdx) {
+  if (groupIdx >= IRRIGATION_GROUPS_COUNT) return 0; // TODO NOTE ERROR?
   return irrigationGroups[groupIdx].nextTimestamp;
 }
 void IrrigationController::getGroup(uint8_t groupIdx, IrrigationGroup& irrGroup) {
@@ -438,21 +478,92 @@ void IrrigationController::getGroup(uint8_t groupIdx, IrrigationGroup& irrGroup)
   memcpy(&irrGroup, &irrigationGroups[groupIdx], sizeof(IrrigationGroup));
 }
 
-void IrrigationController::updateGroup(uint8_t groupIdx, IrrigationGroup& data) {
-  if (groupIdx >= IRRIGATION_GROUPS_COUNT) return; // TODO NOTE ERROR?
-  memcpy(&(irrigationGroups[groupIdx]), &data, sizeof(data));
+bool IrrigationController::setGroup(uint8_t groupIdx, IrrigationGroup& data) {
+  // The struct is received as is, so the raw 'enabled' byte is checked (any other value is not a valid bool)
+  if (
+    groupIdx >= IRRIGATION_GROUPS_COUNT                              ||
+    *((uint8_t*) &data.enabled) > 1                                  ||
+    memchr(data.name, '\0', IRRIGATION_GROUP_NAME_LENGTH) == nullptr ||
+    data.zones >= (1 << IRRIGATION_ZONES_COUNT)                      ||
+    data.source < 0 || data.source >= IRRIGATION_SOURCES_COUNT       ||
+    !isPeriodValid(data.period)                                      ||
+    !isDurationValid(data.duration)                                  ||
+    data.time >= 24*60
+  ) return false;
+
+  IrrigationGroup& irrGroup = irrigationGroups[groupIdx];
+  irrGroup.enabled  = data.enabled;
+  irrGroup.zones    = data.zones;
+  irrGroup.source   = data.source;
+  irrGroup.period   = data.period;
+  irrGroup.duration = data.duration;
+  irrGroup.time     = data.time;
+  memcpy(&(irrGroup.name), &(data.name), IRRIGATION_GROUP_NAME_LENGTH);
+
+  updateNextIrrigationTime(groupIdx);
+
   lastChangeTimestamp++;
+  markGroupChanged(groupIdx);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_SCHEDULE_GROUPS_STATE);
   saveIrrigationGroup(groupIdx);
+
+  return true;
+}
+
+bool IrrigationController::scheduleGroupNow(uint8_t groupIdx) {
+  if (!manualScheduleQueue.push(groupIdx)) return false;
+  wakeTask();
+  return true;
+}
+
+uint16_t IrrigationController::getDroppedJobsCount() {
+  return droppedJobsCount;
+}
+
+bool IrrigationController::addGroupJob(const IrrigationGroup& irrGroup) {
+  if (valvesController->addJob(irrGroup.zones, irrGroup.source, irrGroup.duration)) return true;
+
+  // The job queue is full: the group is not retried until its next irrigation time
+  if (droppedJobsCount < 0xFFFF) droppedJobsCount++;
+  changeTracker->markChanged(CHANGE_FIELD_IRR_DROPPED_JOBS);
+  return false;
+}
+
+
+
+// Controller State Functions ***************************************************************************************************
+
+void IrrigationController::setState(const IrrigationControllerState newState) {
+  if (state == newState) return;
+
+  state = newState;
+  changeTracker->markChanged(CHANGE_FIELD_IRR_CONTROLLER_STATE);
 }
 
-void IrrigationController::scheduleGroupNow(uint8_t groupIdx) {
-  manualScheduleQueue.add(groupIdx);
+void IrrigationController::setManualIrrigationDisableLock(const bool lock) {
+  if (manualIrrigationDisableLock == lock) return;
+
+  manualIrrigationDisableLock = lock;
+  changeTracker->markChanged(CHANGE_FIELD_IRR_MANUAL_DISABLE_STATE);
 }
 
 
 
 // Irrigation Schedule Functions ************************************************************************************************
 
+void IrrigationController::markGroupChanged(const uint8_t groupIdx) {
+  if (groupIdx >= IRRIGATION_GROUPS_COUNT) return;
+
+  updateGroupDeadline(groupIdx);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_GROUP_0 + groupIdx);
+  changeTracker->markChanged(CHANGE_FIELD_IRR_NEXT_IRRIGATION_TIME);
+}
+
+void IrrigationController::updateGroupDeadline(const uint8_t groupIdx) {
+  if (irrigationGroups[groupIdx].enabled) groupDeadlines.set(groupIdx, irrigationGroups[groupIdx].nextTimestamp);
+  else                                    groupDeadlines.remove(groupIdx);
+}
+
 void IrrigationController::updateNextIrrigationTime(uint8_t groupIdx) {
 
   // Update next timestamp
@@ -460,15 +571,18 @@ void IrrigationController::updateNextIrrigationTime(uint8_t groupIdx) {
 
   const uint16_t hours = groupData.time/60;
   const uint16_t minutes = groupData.time - hours*60;
-  DateTime now = clock.now();
+  DateTime now = DateTime(timebase->now());
   DateTime nextIrr = DateTime(now.year(), now.month(), now.day(), hours, minutes);
   if (nextIrr < now) nextIrr = nextIrr + TimeSpan(1, 0, 0, 0);
 
   groupData.nextTimestamp = nextIrr.unixtime();
-  saveIrrigationGroup(groupIdx);
 }
 
 
+bool IrrigationController::isDurationValid(const uint16_t duration) {
+  return duration >= irrigationScheduleConfig.minScheduledDuration && duration <= irrigationScheduleConfig.maxScheduledDuration;
+}
+
 bool IrrigationController::isPeriodValid(const uint8_t period) {
   // If the period is less than 24 h, it must divide 24h without a remainder
   // Otherwise it must be a multiple of 24
@@ -485,6 +599,11 @@ void IrrigationController::loadData() {
   dataSaver->getIrrigationManualConfig(irrigationManualConfig);
   dataSaver->getIrrigationScheduleConfig(irrigationScheduleConfig);
   dataSaver->getGroups(irrigationGroups);
+
+  groupDeadlines.clear();
+  for (uint8_t i = 0; i < IRRIGATION_GROUPS_COUNT; i++) {
+    updateGroupDeadline(i);
+  }
 }
 
 void IrrigationController::saveIrrigationScheduleConfig() {
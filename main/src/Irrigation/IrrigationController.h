@@ -25,7 +25,7 @@
       -- Irrigation Start Time
     - The controller periodically checks if a scheduled irrigation is due, and once it happens it will create
       a new irrigation job via the ElectrovalvesControlThread. Multiple jobs can be scheduled at the same time,
-      which will be executed sequentially.
+      which will be executed sequentially or concurrently within the capacity of their sources.
     - A group can also be manually triggered at any time via the PLC API/Android App.
 
   The controller can be in different states, each of which will result in a different instruction loop being triggered
@@ -35,11 +35,12 @@
     1. If manual mode is turned on, there is no scheduled irrigation onging, and the manual mode is not disabled, 
        turn on manual irrigation and change the state of the controller to 'MANUAL_JOB'.
     2. If auto mode is enabled on the PLC control panel, check whether an irrigation group has been manually triggered
-       via the API/Android App. If that's the case, turn on that irrigation group and change the state of the controller 
+       via the API/Android App. If that's the case, turn on those irrigation groups and change the state of the controller 
        to 'SCHDULED_JOB'.
     3. If auto mode is enabled on the PLC control panel, and the irrigation schedule is enabled (via the API/Android App),
-       check every irrigation group, and turn them on if necessary. If any group is due, change the state of the controller
-       to 'SCHEDULED_JOB'.
+       turn on the irrigation groups that are due, if any, and change the state of the controller to 'SCHEDULED_JOB'.
+       The enabled groups are kept sorted by next irrigation time in a DeadlineIndex (updated whenever a group changes,
+       see 'markGroupChanged'), so that only the earliest deadline has to be checked on each run.
   
   MANUAL_JOB state:
     1. If manual mode is turned off, or the ElectrovalvesControlThread indicates that there is no job ongoing (e.g. timeout),
@@ -50,6 +51,8 @@
        of the controller to 'IDLE'.
     2. If auto mode gets disabled on the PLC control panel, cancel all active/pending irrigations and revert the state of 
        the controller to 'IDLE'.
+    3. Otherwise, add the jobs of the manually triggered groups and of the due groups (as in the IDLE state), so that they
+       are queued while the ongoing jobs run.
 */
 
 #ifndef IrrigationController_h
@@ -57,7 +60,6 @@
 
 #include <Arduino.h>
 #include <RTClib.h>
-#include <LinkedList.h>
 
 #include "ElectrovalvesControlThread.h"
 #include "IrrigationControllerTypes.h"
@@ -65,6 +67,10 @@
 #include "../ControllerConfig.h"
 #include "../Utils/DataSaver.h"
 #include "../Utils/InterfaceUtils.h"
+#include "../Utils/ChangeTracker.h"
+#include "../Utils/Timebase.h"
+#include "../Utils/DeadlineIndex.h"
+#include "../Utils/RingBuffer.h"
 #include "../TaskScheduler/TaskSchedulerThread.h"
 
 enum class IrrigationControllerState {
@@ -79,7 +85,8 @@ class IrrigationController: public Task
         IrrigationController(
           ElectrovalvesControlThread*& valvesControllerPtr,
           DataSaver*&                  dataSaver,
-          RTC_DS3231&                  rtcClock
+          ChangeTracker*&              changeTracker,
+          Timebase*&                   timebase
         );
 
         InputSignal* manualIrrigationEnable   = new InputSignal(IRRIGATION_FROM_SWIMMING_POOL_ENABLE_INPUT_PIN);
@@ -89,12 +96,14 @@ class IrrigationController: public Task
         void resetIrrigationManualConfig();
         void resetGroup(uint8_t groupIdx);
         void reset();
+        void reload();      // Reloads the configuration from the EEPROM (e.g. after a configuration image import)
 
         // Controller Loops
         void runTask(const PLCState& state);
         void idleLoop(const PLCState& state);
         void manualLoop(const PLCState& state);
         void scheduledLoop(const PLCState& state);
+        void addScheduledJobs(const PLCState& state);
 
         // Controller State Methods
         uint32_t getLastChangeTimestamp();
@@ -147,14 +156,16 @@ class IrrigationController: public Task
         uint32_t getGroupNextIrrigationTime(uint8_t groupIdx);
 
         void     getGroup(uint8_t groupIdx, IrrigationGroup& irrGroup);
-        void     updateGroup(uint8_t groupIdx, IrrigationGroup& data);
+        bool     setGroup(uint8_t groupIdx, IrrigationGroup& data);    // Validates the group settings, returns false if invalid
 
-        void     scheduleGroupNow(uint8_t groupIdx);
+        bool     scheduleGroupNow(uint8_t groupIdx);    // Returns false if the manual schedule queue is full
+        uint16_t getDroppedJobsCount();                 // Group jobs dropped because the job queue was full (since boot)
 
     private:
         ElectrovalvesControlThread*& valvesController;
         DataSaver*&                  dataSaver;
-        RTC_DS3231&                  clock;
+        ChangeTracker*&              changeTracker;
+        Timebase*&                   timebase;
 
         IrrigationManualConfig   irrigationManualConfig;
         IrrigationScheduleConfig irrigationScheduleConfig;
@@ -163,11 +174,21 @@ class IrrigationController: public Task
         IrrigationControllerState state = IrrigationControllerState::IDLE;
         uint32_t lastChangeTimestamp = 0;
         bool manualIrrigationDisableLock = true; // Prevents manual irrigation turn on if it is set whilst in automatic mode
-        LinkedList<uint8_t> manualScheduleQueue = LinkedList<uint8_t>();
+        RingBuffer<uint8_t, IRRIGATION_GROUPS_COUNT> manualScheduleQueue;   // Groups scheduled via the communication API
+        DeadlineIndex<IRRIGATION_GROUPS_COUNT> groupDeadlines;  // Next irrigation time of the enabled groups
+        uint16_t droppedJobsCount = 0;
+
+        // Controller State Functions
+        void setState(const IrrigationControllerState newState);
+        void setManualIrrigationDisableLock(const bool lock);
 
         // Irrigation Schedule Functions
-        void updateNextIrrigationTime(uint8_t groupIdx);
+        void markGroupChanged(const uint8_t groupIdx);    // Also updates the group deadline
+        void updateGroupDeadline(const uint8_t groupIdx);
+        void updateNextIrrigationTime(uint8_t groupIdx);  // Not saved (see saveIrrigationGroup)
+        bool isDurationValid(const uint16_t duration);    // Scheduled duration limits (inclusive)
         bool isPeriodValid(const uint8_t period);
+        bool addGroupJob(const IrrigationGroup& irrGroup);  // Counts the job as dropped if the job queue is full
 
         // Data Management Methods
         void loadData();
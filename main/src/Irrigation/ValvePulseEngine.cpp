@@ -0,0 +1,228 @@
+/*
+  ValvePulseEngine.cpp
+*/
+#include "ValvePulseEngine.h"
+
+// Time in us
+const uint16_t MULTIPLEXER_SIGNAL_DELAY = 100;
+
+// The select pins are written at once, so that the address does not go through intermediate values
+const uint8_t MULTIPLEXER_SELECT_PORT = fastPinPort(MULTIPLEXER_SELECT_PIN_0);
+const uint8_t MULTIPLEXER_SELECT_MASK = fastPinMask(MULTIPLEXER_SELECT_PIN_0) | fastPinMask(MULTIPLEXER_SELECT_PIN_1) |
+                                        fastPinMask(MULTIPLEXER_SELECT_PIN_2) | fastPinMask(MULTIPLEXER_SELECT_PIN_3);
+
+static_assert(
+    fastPinPort(MULTIPLEXER_SELECT_PIN_1) == MULTIPLEXER_SELECT_PORT &&
+    fastPinPort(MULTIPLEXER_SELECT_PIN_2) == MULTIPLEXER_SELECT_PORT &&
+    fastPinPort(MULTIPLEXER_SELECT_PIN_3) == MULTIPLEXER_SELECT_PORT,
+    "The multiplexer select pins must be on the same port"
+);
+
+#if VALVE_PULSE_ENGINE_TIMER
+// Timer1 ticks
+const uint32_t TIMER_PRESCALER = 64;
+const uint32_t TIMER_CLOCK_MHZ = F_CPU / 1000000UL;
+const uint16_t TIMER_MIN_TICKS = 4;         // Enough for the interrupt to return before the next match
+const uint16_t TIMER_MAX_TICKS = 0x8000;    // Ticks loaded at once into the timer for the long phases
+
+static ValvePulseEngine* timerEngine = nullptr;
+
+ISR(TIMER1_COMPA_vect) {
+    if (timerEngine != nullptr) timerEngine->onTimer();
+}
+#endif
+
+
+ValvePulseEngine::ValvePulseEngine()
+{
+    // Multiplexer - Zones
+    pinMode(MULTIPLEXER_SELECT_PIN_0, OUTPUT);
+    pinMode(MULTIPLEXER_SELECT_PIN_1, OUTPUT);
+    pinMode(MULTIPLEXER_SELECT_PIN_2, OUTPUT);
+    pinMode(MULTIPLEXER_SELECT_PIN_3, OUTPUT);
+    pinMode(MULTIPLEXER_SIGNAL_PIN, OUTPUT);
+    setMultSignalState(false);
+
+#if VALVE_PULSE_ENGINE_TIMER
+    timerEngine = this;
+#endif
+}
+
+
+
+// Queue functions **************************************************************************************************************
+
+bool ValvePulseEngine::enqueue(const uint8_t channel, const uint16_t width, const uint16_t gap) {
+    noInterrupts();
+
+    if (queueCount >= VALVE_PULSE_QUEUE_LENGTH) {
+        interrupts();
+        return false;
+    }
+
+    volatile ValvePulse& pulse = queue[(queueHead + queueCount) % VALVE_PULSE_QUEUE_LENGTH];
+    pulse.channel = channel;
+    pulse.width   = width;
+    pulse.gap     = gap;
+    queueCount++;
+
+    if (phase == PULSE_IDLE) {
+        startTimer();
+        startPulse();
+    }
+
+    interrupts();
+    return true;
+}
+
+void ValvePulseEngine::cancel() {
+    noInterrupts();
+
+    stopTimer();
+    setMultSignalState(false);
+    queueCount = 0;
+    phase      = PULSE_IDLE;
+
+    interrupts();
+}
+
+bool ValvePulseEngine::isBusy() {
+    return phase != PULSE_IDLE;
+}
+
+uint8_t ValvePulseEngine::getFreeSlots() {
+    return VALVE_PULSE_QUEUE_LENGTH - queueCount;
+}
+
+
+
+// Pulse functions **************************************************************************************************************
+
+void ValvePulseEngine::startPulse() {
+    setMultInputPins(queue[queueHead].channel);     // Set multiplexer address
+    phase = PULSE_SETTLING;
+    schedule(MULTIPLEXER_SIGNAL_DELAY);             // Wait for multiplexer to be set
+}
+
+// Ends the active phase and starts the next one
+void ValvePulseEngine::step() {
+    switch (phase) {
+        case PULSE_SETTLING:
+            setMultSignalState(true);
+            phase = PULSE_HIGH;
+            schedule(queue[queueHead].width * 1000UL);
+            break;
+
+        case PULSE_HIGH:
+            setMultSignalState(false);
+            phase = PULSE_GAP;
+            schedule(queue[queueHead].gap * 1000UL);
+            break;
+
+        case PULSE_GAP:
+            // Pulse completed
+            queueHead = (queueHead + 1) % VALVE_PULSE_QUEUE_LENGTH;
+            queueCount--;
+
+            if (queueCount > 0) {
+                startPulse();
+            }
+            else {
+                phase = PULSE_IDLE;
+                stopTimer();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+
+// Timing functions *************************************************************************************************************
+
+#if VALVE_PULSE_ENGINE_TIMER
+
+void ValvePulseEngine::startTimer() {
+    // The timer clock is only enabled once the first period has been loaded (see 'loadTimer')
+    TCCR1B = 0;
+    TCCR1A = 0;
+    TCNT1  = 0;
+    TIFR1  = _BV(OCF1A);        // Clear any pending match
+    TIMSK1 = _BV(OCIE1A);
+}
+
+void ValvePulseEngine::stopTimer() {
+    TCCR1B = 0;
+    TIMSK1 = 0;
+}
+
+void ValvePulseEngine::schedule(const uint32_t duration) {
+    remainingTicks = max(duration * TIMER_CLOCK_MHZ / TIMER_PRESCALER, (uint32_t) TIMER_MIN_TICKS);
+    loadTimer();
+}
+
+void ValvePulseEngine::loadTimer() {
+    // The long phases are split into TIMER_MAX_TICKS periods, which leaves at least TIMER_MAX_TICKS for the last one
+    const uint16_t ticks = remainingTicks > 0xFFFF ? TIMER_MAX_TICKS : remainingTicks;
+    remainingTicks -= ticks;
+
+    // In CTC mode the counter is cleared on every match (which keeps the phases free of the interrupt latency), so only
+    // the period of the next match has to be set: the counter is always well below it at this point
+    OCR1A  = ticks - 1;
+    TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10);   // CTC mode (TOP = OCR1A), clk/64
+}
+
+void ValvePulseEngine::onTimer() {
+    if (remainingTicks > 0) loadTimer();
+    else                    step();
+}
+
+void ValvePulseEngine::service() {
+}
+
+#else
+
+void ValvePulseEngine::startTimer() {
+    phaseDeadline = micros();
+}
+
+void ValvePulseEngine::stopTimer() {
+}
+
+void ValvePulseEngine::schedule(const uint32_t duration) {
+    // Relative to the end of the previous phase, so that a late 'service' call does not delay the following phases
+    phaseDeadline += duration;
+}
+
+void ValvePulseEngine::onTimer() {
+    step();
+}
+
+void ValvePulseEngine::service() {
+    while (phase != PULSE_IDLE && (int32_t) (micros() - phaseDeadline) >= 0) {
+        onTimer();
+    }
+}
+
+#endif
+
+
+
+// Multiplexer functions ********************************************************************************************************
+
+// Set the address of the multiplexer
+void ValvePulseEngine::setMultInputPins(const uint8_t inputIndex) {
+    const uint8_t value = ((inputIndex & 1) != 0 ? fastPinMask(MULTIPLEXER_SELECT_PIN_0) : 0) |
+                          ((inputIndex & 2) != 0 ? fastPinMask(MULTIPLEXER_SELECT_PIN_1) : 0) |
+                          ((inputIndex & 4) != 0 ? fastPinMask(MULTIPLEXER_SELECT_PIN_2) : 0) |
+                          ((inputIndex & 8) != 0 ? fastPinMask(MULTIPLEXER_SELECT_PIN_3) : 0);
+
+    fastPortWrite(MULTIPLEXER_SELECT_PORT, MULTIPLEXER_SELECT_MASK, value);
+}
+
+// Set the state of the signal going into the multiplexer
+void ValvePulseEngine::setMultSignalState(const bool state) {
+    fastPinWrite(MULTIPLEXER_SIGNAL_PIN, state);
+}
@@ -0,0 +1,85 @@
+/*
+  ValvePulseEngine.h
+
+  Sends the pulses that latch/unlatch the DC solenoid electrovalves via the multiplexer, independently of the main loop.
+
+  The pulses (multiplexer channel, width, gap) are queued with 'enqueue' and are sent in order: for every pulse the
+  multiplexer address is set, the signal is set high after MULTIPLEXER_SIGNAL_DELAY us, kept high for 'width' ms and then
+  kept low for 'gap' ms before the next pulse is started. The pulse is completed once its gap has elapsed.
+
+  On the AVR boards, the phases are timed by the Timer1 compare match interrupt (CTC mode, 4 us resolution at 16 MHz),
+  so the pulse widths do not depend on how often the main loop runs (e.g. whilst a response is transmitted or the EEPROM
+  is written). The timer is stopped whilst the queue is empty. Note that Timer1 cannot be used for anything else (e.g.
+  the Servo library or PWM on pins 9/10).
+  Where Timer1 is not available (e.g. the host simulation) the phases are polled by 'service', which must then be called
+  from the main loop.
+*/
+#ifndef ValvePulseEngine_h
+#define ValvePulseEngine_h
+
+#include <Arduino.h>
+
+#include "../ControllerConfig.h"
+#include "../Utils/FastPin.h"
+
+#if defined(TIMSK1) && defined(OCIE1A)
+#define VALVE_PULSE_ENGINE_TIMER 1
+#else
+#define VALVE_PULSE_ENGINE_TIMER 0
+#endif
+
+static_assert(VALVE_PULSE_QUEUE_LENGTH >= IRRIGATION_ZONES_COUNT, "The pulses of every zone must fit in the pulse queue");
+
+
+enum ValvePulsePhase : uint8_t {
+    PULSE_IDLE = 0,
+    PULSE_SETTLING,     // Multiplexer address set, waiting for it to settle
+    PULSE_HIGH,
+    PULSE_GAP
+};
+
+struct ValvePulse {
+    uint8_t  channel;   // Multiplexer output
+    uint16_t width;     // ms
+    uint16_t gap;       // ms
+};
+
+class ValvePulseEngine
+{
+    public:
+        ValvePulseEngine();
+
+        bool enqueue(const uint8_t channel, const uint16_t width, const uint16_t gap);  // Returns false if the queue is full
+        void cancel();      // Drops the queued pulses, cutting short the active one
+
+        bool    isBusy();   // True until every queued pulse has been completed
+        uint8_t getFreeSlots();
+
+        void service();     // Polled fallback (no-op if the pulses are timed by Timer1)
+        void onTimer();     // Timer1 compare match interrupt
+
+    private:
+        volatile ValvePulse      queue[VALVE_PULSE_QUEUE_LENGTH];
+        volatile uint8_t         queueHead  = 0;
+        volatile uint8_t         queueCount = 0;
+        volatile ValvePulsePhase phase      = PULSE_IDLE;
+
+#if VALVE_PULSE_ENGINE_TIMER
+        volatile uint32_t remainingTicks;   // Ticks of the active phase not loaded into the timer yet
+        void loadTimer();
+#else
+        uint32_t phaseDeadline;             // micros()
+#endif
+
+        void startTimer();
+        void stopTimer();
+        void schedule(const uint32_t duration);     // us
+
+        void startPulse();
+        void step();
+
+        void setMultInputPins(const uint8_t inputIndex);
+        void setMultSignalState(const bool state);
+};
+
+#endif
@@ -5,18 +5,19 @@
 */
 
 SwimmingPoolController::SwimmingPoolController(
-    DataSaver*& dataSaver
-) : dataSaver(dataSaver)
+    DataSaver*&     dataSaver,
+    ChangeTracker*& changeTracker
+) : dataSaver(dataSaver), changeTracker(changeTracker)
 {
+    setTaskInterval(SWIMMING_POOL_TASK_INTERVAL);
     initialise();
     loadConfig();
     loadSchedule();
 }
 
 void SwimmingPoolController::initialise() {
-    state = SwimmingPoolControllerState::IDLE;
-
-    recirculationPumpManualOverrideLock = true;
+    setState(SwimmingPoolControllerState::IDLE);
+    setManualOverrideLock(true);
 
     turnOnTime                          = 0;
     nextTurnOffTime                     = 0;
@@ -27,6 +28,7 @@ void SwimmingPoolController::initialise() {
 void SwimmingPoolController::reset() {
     turnPumpOff();
     turnUVOff();
+    outputs.commit();
 
     config.maxScheduledTurnOnTimeout         = 3600;
     config.minScheduledDuration              = 5*60;
@@ -41,18 +43,39 @@ void SwimmingPoolController::reset() {
     schedule.duration       = 0;          // Set to min value
     schedule.periodDays     = 255;        // Set to max value 2^8-1
     saveSchedule();
+
+    changeTracker->markChanged(CHANGE_FIELD_SP_SCHEDULE_ENABLE);
+    changeTracker->markChanged(CHANGE_FIELD_SP_SCHEDULE_NEXT);
+    changeTracker->markChanged(CHANGE_FIELD_SP_SCHEDULE_DURATION);
+    changeTracker->markChanged(CHANGE_FIELD_SP_SCHEDULE_PERIOD);
     
     initialise();
 }
 
+void SwimmingPoolController::reload() {
+    loadConfig();
+    loadSchedule();
+    lastChangeTimestamp++;
+
+    changeTracker->markChanged(CHANGE_FIELD_SP_SCHEDULE_ENABLE);
+    changeTracker->markChanged(CHANGE_FIELD_SP_SCHEDULE_NEXT);
+    changeTracker->markChanged(CHANGE_FIELD_SP_SCHEDULE_DURATION);
+    changeTracker->markChanged(CHANGE_FIELD_SP_SCHEDULE_PERIOD);
+}
+
 
 
 // Controller Loops *************************************************************************************************************
 
 void SwimmingPoolController::runTask(const PLCState& plcState) {
 
+    // Track input changes
+    changeTracker->trackValue(CHANGE_FIELD_SP_PUMP_MANUAL_VALUE, manualOverride->value());
+    changeTracker->trackValue(CHANGE_FIELD_SP_UV_ENABLE_VALUE,   UVEnable->value());
+
     // Read recirculation sensor
     recirculationState = recirculationSensor->value();
+    changeTracker->trackValue(CHANGE_FIELD_SP_FLOW_SENSOR_VALUE, recirculationState);
     if (recirculationState) {
         if (recirculationFlowStartDetectionTime == 0) {
             recirculationFlowStartDetectionTime = plcState.time;
@@ -109,6 +132,8 @@ void SwimmingPoolController::runTask(const PLCState& plcState) {
         turnUVOff();
         lastChangeTimestamp = plcState.time;
     }
+
+    outputs.commit();
 }
 
 void SwimmingPoolController::idleLoop(const PLCState& plcState) {
@@ -117,7 +142,7 @@ void SwimmingPoolController::idleLoop(const PLCState& plcState) {
         if (!recirculationPumpManualOverrideLock) { // Make sure manual mode isn't disabled
             // Turn pump on
             turnPumpOn(plcState.time);
-            state = SwimmingPoolControllerState::MANUAL_JOB;
+            setState(SwimmingPoolControllerState::MANUAL_JOB);
             lastChangeTimestamp = plcState.time;
             return;
         }
@@ -125,7 +150,7 @@ void SwimmingPoolController::idleLoop(const PLCState& plcState) {
     }
     else {
         if (recirculationPumpManualOverrideLock) {
-            recirculationPumpManualOverrideLock = false;
+            setManualOverrideLock(false);
             lastChangeTimestamp = plcState.time;
         }
     }
@@ -143,7 +168,7 @@ void SwimmingPoolController::idleLoop(const PLCState& plcState) {
         ) {
             turnPumpOn(plcState.time);
             nextTurnOffTime = plcState.time + schedule.duration*60;
-            state = SwimmingPoolControllerState::SCHEDULED_JOB;
+            setState(SwimmingPoolControllerState::SCHEDULED_JOB);
         }
         else {
             // TODO NOTE ERROR SOMEHOW?
@@ -154,6 +179,7 @@ void SwimmingPoolController::idleLoop(const PLCState& plcState) {
         schedule.nextTurnOnTime += (floor( (plcState.time - schedule.nextTurnOnTime)/periodInSeconds ) + 1)*periodInSeconds;
 
         saveSchedule();
+        changeTracker->markChanged(CHANGE_FIELD_SP_SCHEDULE_NEXT);
         lastChangeTimestamp = plcState.time;
     }
 }
@@ -161,7 +187,7 @@ void SwimmingPoolController::idleLoop(const PLCState& plcState) {
 void SwimmingPoolController::manualLoop(const PLCState& plcState) {
     if (!manualOverride->value()) {
         turnPumpOff();
-        state = SwimmingPoolControllerState::IDLE;
+        setState(SwimmingPoolControllerState::IDLE);
         lastChangeTimestamp = plcState.time;
     }
 }
@@ -172,13 +198,13 @@ void SwimmingPoolController::scheduledLoop(const PLCState& plcState) {
     // (avoid the pump turning on indefinately after the scheduled timer finishes)
     if (manualOverride->value()) {
         if (!recirculationPumpManualOverrideLock) {
-            recirculationPumpManualOverrideLock = true;
+            setManualOverrideLock(true);
             lastChangeTimestamp = plcState.time;
         }
     }
     else {
         if (recirculationPumpManualOverrideLock) {
-            recirculationPumpManualOverrideLock = false;
+            setManualOverrideLock(false);
             lastChangeTimestamp = plcState.time;
         }
     }
@@ -190,7 +216,7 @@ void SwimmingPoolController::scheduledLoop(const PLCState& plcState) {
         plcState.time >= nextTurnOffTime
     ) {
         turnPumpOff();
-        state = SwimmingPoolControllerState::IDLE;
+        setState(SwimmingPoolControllerState::IDLE);
         lastChangeTimestamp = plcState.time;
         return;
     }
@@ -198,7 +224,7 @@ void SwimmingPoolController::scheduledLoop(const PLCState& plcState) {
     // Failsafe - nextTurnOffTime is too far away (rtc time change?)
     if ((nextTurnOffTime - plcState.time) >= config.maxScheduledDuration) {
         turnPumpOff();
-        state = SwimmingPoolControllerState::IDLE;
+        setState(SwimmingPoolControllerState::IDLE);
         lastChangeTimestamp = plcState.time;
         return;
         // TODO note error?
@@ -211,7 +237,7 @@ void SwimmingPoolController::scheduledLoop(const PLCState& plcState) {
         (plcState.time - recirculationFlowStopDetectionTime) >= config.recirculationStopDetectionTimeout
     ) {
         turnPumpOff();
-        state = SwimmingPoolControllerState::IDLE;
+        setState(SwimmingPoolControllerState::IDLE);
         lastChangeTimestamp = plcState.time;
         // TODO note error?
     }
@@ -240,12 +266,14 @@ bool SwimmingPoolController::getRecirculationPumpManualOverrideLockState() {
 void SwimmingPoolController::enableSchedule() {
     schedule.scheduleEnable = true;
     lastChangeTimestamp++;
+    changeTracker->markChanged(CHANGE_FIELD_SP_SCHEDULE_ENABLE);
     saveSchedule();
 }
 
 void SwimmingPoolController::disableSchedule() {
     schedule.scheduleEnable = false;
     lastChangeTimestamp++;
+    changeTracker->markChanged(CHANGE_FIELD_SP_SCHEDULE_ENABLE);
     saveSchedule();
 }
 
@@ -261,6 +289,7 @@ uint32_t SwimmingPoolController::getNextTurnOnTime() {
 void SwimmingPoolController::setNextTurnOnTime(uint32_t nextTurnOnTime) {
     schedule.nextTurnOnTime = nextTurnOnTime;
     lastChangeTimestamp++;
+    changeTracker->markChanged(CHANGE_FIELD_SP_SCHEDULE_NEXT);
     saveSchedule();
 }
 
@@ -272,6 +301,7 @@ uint16_t SwimmingPoolController::getDuration() {
 void SwimmingPoolController::setDuration(uint16_t duration) {
     schedule.duration = duration;
     lastChangeTimestamp++;
+    changeTracker->markChanged(CHANGE_FIELD_SP_SCHEDULE_DURATION);
     saveSchedule();
 }
 
@@ -284,33 +314,61 @@ void SwimmingPoolController::setPeriodDays(uint8_t periodDays) {
     if (periodDays == 0) return;
     schedule.periodDays = periodDays;
     lastChangeTimestamp++;
+    changeTracker->markChanged(CHANGE_FIELD_SP_SCHEDULE_PERIOD);
     saveSchedule();
 }
 
 void SwimmingPoolController::stopJob() {
     nextTurnOffTime = 0;
+    wakeTask();
 }
 
 
 
 // Helper Methods ***************************************************************************************************************
 
+// The fields are only marked as changed if their value changes, so that the change version is not bumped needlessly
+
+void SwimmingPoolController::setState(const SwimmingPoolControllerState newState) {
+    if (state == newState) return;
+
+    state = newState;
+    changeTracker->markChanged(CHANGE_FIELD_SP_CONTROLLER_STATE);
+}
+
+void SwimmingPoolController::setManualOverrideLock(const bool lock) {
+    if (recirculationPumpManualOverrideLock == lock) return;
+
+    recirculationPumpManualOverrideLock = lock;
+    changeTracker->markChanged(CHANGE_FIELD_SP_PUMP_MANUAL_DISABLE);
+}
+
 void SwimmingPoolController::turnPumpOn(const uint32_t time) {
-    swimmingPoolRecirculationPump->turnOn();
+    const bool changed = !swimmingPoolRecirculationPump->getState();
+    swimmingPoolRecirculationPump->turnOn(&outputs);
     turnOnTime = time;
+    if (changed) changeTracker->markChanged(CHANGE_FIELD_SP_PUMP_STATE);
 }
 
 void SwimmingPoolController::turnPumpOff() {
-    swimmingPoolRecirculationPump->turnOff();
+    const bool changed = swimmingPoolRecirculationPump->getState();
+    swimmingPoolRecirculationPump->turnOff(&outputs);
     turnOnTime = 0;
+    if (changed) changeTracker->markChanged(CHANGE_FIELD_SP_PUMP_STATE);
 }
 
 void SwimmingPoolController::turnUVOn() {
-    uvDisinfectLight->turnOn();
+    if (uvDisinfectLight->getState()) return;
+
+    uvDisinfectLight->turnOn(&outputs);
+    changeTracker->markChanged(CHANGE_FIELD_SP_UV_STATE);
 }
 
 void SwimmingPoolController::turnUVOff() {
-    uvDisinfectLight->turnOff();
+    if (!uvDisinfectLight->getState()) return;
+
+    uvDisinfectLight->turnOff(&outputs);
+    changeTracker->markChanged(CHANGE_FIELD_SP_UV_STATE);
 }
 
 
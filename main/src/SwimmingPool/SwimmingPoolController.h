@@ -47,6 +47,7 @@
 
 #include "../Utils/DataSaver.h"
 #include "../Utils/InterfaceUtils.h"
+#include "../Utils/ChangeTracker.h"
 
 #include "../TaskScheduler/TaskSchedulerThread.h"
 
@@ -60,7 +61,8 @@ class SwimmingPoolController: public Task
 {
     public:
         SwimmingPoolController(
-            DataSaver*& dataSaver
+            DataSaver*&     dataSaver,
+            ChangeTracker*& changeTracker
         );
 
         InputSignal* manualOverride                = new InputSignal(SWIMMING_POOL_PUMP_ENABLE_INPUT_PIN);
@@ -69,9 +71,11 @@ class SwimmingPoolController: public Task
 
         OutputRelay* swimmingPoolRecirculationPump = new OutputRelay(SWIMMING_POOL_RECIRCULATION_PUMP_PIN);
         OutputRelay* uvDisinfectLight              = new OutputRelay(UV_DISINFECT_LIGHT_PIN);
+        OutputBatch  outputs;   // Relay changes of a run, committed at once at the end of it
 
-        // Reset Method
+        // Reset Methods
         void reset();
+        void reload();      // Reloads the configuration from the EEPROM (e.g. after a configuration image import)
         void stopJob();
 
         // Controller Loops
@@ -100,7 +104,8 @@ class SwimmingPoolController: public Task
         void     setPeriodDays(uint8_t periodDays);
 
     private:
-        DataSaver*& dataSaver;
+        DataSaver*&     dataSaver;
+        ChangeTracker*& changeTracker;
 
         SwimmingPoolControllerState state;
         uint32_t lastChangeTimestamp = 0;
@@ -119,6 +124,9 @@ class SwimmingPoolController: public Task
         void initialise();
 
         // Helper Methods
+        void setState(const SwimmingPoolControllerState newState);
+        void setManualOverrideLock(const bool lock);
+
         void turnPumpOn(const uint32_t time);
         void turnPumpOff();
 
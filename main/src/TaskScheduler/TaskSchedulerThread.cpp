@@ -0,0 +1,95 @@
+/*
+  TaskSchedulerThread.cpp
+*/
+#include "TaskSchedulerThread.h"
+
+
+void Task::wakeTask() {
+  taskNextRun = millis();
+  if (scheduler != nullptr) scheduler->wake();
+}
+
+
+
+TaskSchedulerThread::TaskSchedulerThread(Timebase*& timebase, ChangeTracker*& changeTracker)
+  : timebase(timebase), changeTracker(changeTracker)
+{
+  // Check time
+  if (timebase->now() < defaultRTCTime) {
+    timebase->adjust(defaultRTCTime);
+  }
+}
+
+bool TaskSchedulerThread::addTask(Task* task) {
+  if (tasksCount >= TASK_SCHEDULER_MAX_TASKS) return false;
+
+  task->scheduler   = this;
+  task->taskNextRun = millis();
+  tasks[tasksCount++] = task;
+
+  wake();
+  return true;
+}
+
+void TaskSchedulerThread::run() {
+  const uint32_t currentMillis = millis();
+
+  state.time = timebase->now();
+  if (state.autoModeState != autoEnableSignal->value()) {
+    state.autoModeState = autoEnableSignal->value();
+    lastChangeTimestamp = state.time;
+    changeTracker->markChanged(CHANGE_FIELD_AUTO_MODE);
+
+    // Let every task react to the new state at once
+    for (uint8_t i = 0; i < tasksCount; i++) {
+      tasks[i]->taskNextRun = currentMillis;
+    }
+  }
+
+  for (uint8_t i = 0; i < tasksCount; i++) {
+    Task* task = tasks[i];
+    if ((int32_t) (currentMillis - task->taskNextRun) < 0) continue;
+
+    task->taskNextRun = currentMillis + task->taskInterval;
+    task->runTask(state);
+  }
+
+  // Do not run again until the next task is due (the auto mode state is polled at the same rate)
+  setInterval(getIdleTime());
+  runned(currentMillis);
+}
+
+void TaskSchedulerThread::wake() {
+  // Due from now on (rather than from the last run), so that the run statistics measure the lateness from the wake up
+  setInterval(millis() - last_run);
+}
+
+uint32_t TaskSchedulerThread::getIdleTime() {
+  const uint32_t currentMillis = millis();
+  uint32_t idleTime = 0xFFFFFFFF;
+
+  for (uint8_t i = 0; i < tasksCount; i++) {
+    const int32_t timeLeft = tasks[i]->taskNextRun - currentMillis;
+    if (timeLeft <= 0) return 0;
+    if ((uint32_t) timeLeft < idleTime) idleTime = timeLeft;
+  }
+
+  return idleTime;
+}
+
+uint32_t TaskSchedulerThread::getTime() {
+  return timebase->now();
+}
+
+void TaskSchedulerThread::setTime(uint32_t time) {
+  timebase->adjust(time);
+  lastChangeTimestamp = getTime();
+}
+
+uint32_t TaskSchedulerThread::getLastChangeTimestamp() {
+  return lastChangeTimestamp;
+}
+
+bool TaskSchedulerThread::getAutoModeState() {
+  return autoEnableSignal->value();
+}
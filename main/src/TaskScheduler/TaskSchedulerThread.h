@@ -1,14 +1,24 @@
 /*
   TaskSchedulerThread.h
+
+  Runs the controllers (Tasks) with the PLC state (time + auto mode state).
+
+  Each task declares its own run interval, and is only run once it is due. The scheduler then sets its own thread
+  interval to the time left until the next task is due, so that it is not run at all in between. A task can be woken
+  up at any time (e.g. after a change requested via the communication API) to be run on the next loop. Every task is
+  also woken up whenever the auto mode state changes.
+  Tasks are registered with 'addTask', up to TASK_SCHEDULER_MAX_TASKS.
 */
 #ifndef TaskSchedulerThread_h
 #define TaskSchedulerThread_h
 
 #include <Arduino.h>
 #include <Thread.h>
-#include <RTClib.h>
 
+#include "../ControllerConfig.h"
 #include "../Utils/InterfaceUtils.h"
+#include "../Utils/ChangeTracker.h"
+#include "../Utils/Timebase.h"
 
 
 struct PLCState {
@@ -17,76 +27,60 @@ struct PLCState {
 };
 
 
+class TaskSchedulerThread;
+
 class Task
 {
     public:
-        virtual void runTask(const PLCState& state);
+        virtual void runTask(const PLCState& state) = 0;
+
+    protected:
+        void setTaskInterval(const uint16_t interval) {     // ms
+            taskInterval = interval;
+        }
+
+        void wakeTask();    // Runs the task on the next loop of the scheduler
+
+    private:
+        friend class TaskSchedulerThread;
+
+        TaskSchedulerThread* scheduler    = nullptr;
+        uint16_t             taskInterval = 1;
+        uint32_t             taskNextRun  = 0;    // millis()
 };
 
 
 static const uint32_t defaultRTCTime = 1640991600;
 
-template <uint8_t T>
 class TaskSchedulerThread: public Thread
 {
   public:
-    TaskSchedulerThread(Task* tasks[T], RTC_DS3231 & rtcClock)
-        : clock(rtcClock)
-    {
-        // Check time
-        DateTime date = clock.now();
-        const uint32_t rtcTime = date.unixtime();
-        if (rtcTime < defaultRTCTime) {
-            clock.adjust(DateTime(defaultRTCTime));
-        }
+    TaskSchedulerThread(Timebase*& timebase, ChangeTracker*& changeTracker);
 
-        // Save tasks
-        for (uint8_t i = 0; i < T; i++) {
-            _tasks[i] = tasks[i];
-        }
-    }
-
-    void run() {
-        state.time = clock.now().unixtime();
-        if (state.autoModeState != autoEnableSignal->value()) {
-            state.autoModeState = autoEnableSignal->value();
-            lastChangeTimestamp = state.time;
-        }
-
-        for (uint8_t i = 0; i < T; i++) {
-            _tasks[i]->runTask(state);
-        }
-
-        runned();
-    }
+    bool addTask(Task* task);   // Returns false if the maximum number of tasks has been reached
 
-    uint32_t getTime() {
-        return clock.now().unixtime();
-    }
+    void run();
+    void wake();                // Runs the scheduler on the next loop
+    uint32_t getIdleTime();     // Time left until the next task is due (ms)
 
-    void setTime(uint32_t time) {
-        clock.adjust(DateTime(time));
-        lastChangeTimestamp = getTime();
-    }
+    uint32_t getTime();
+    void     setTime(uint32_t time);
 
-    uint32_t getLastChangeTimestamp() {
-        return lastChangeTimestamp;
-    }
+    uint32_t getLastChangeTimestamp();
+    bool     getAutoModeState();
 
-    bool getAutoModeState() {
-        return autoEnableSignal->value();
-    }
-
-  
   private:
-        RTC_DS3231& clock;
-        Task* _tasks[T];
+    Timebase*&      timebase;
+    ChangeTracker*& changeTracker;
+
+    Task*   tasks[TASK_SCHEDULER_MAX_TASKS];
+    uint8_t tasksCount = 0;
 
-        InputSignal* autoEnableSignal = new InputSignal(AUTO_MODE_ENABLE_INPUT_PIN);
+    InputSignal* autoEnableSignal = new InputSignal(AUTO_MODE_ENABLE_INPUT_PIN);
 
-        PLCState state;
+    PLCState state = {};
 
-        uint32_t lastChangeTimestamp = 0;
+    uint32_t lastChangeTimestamp = 0;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,99 @@
+/*
+  TimedThreadController.cpp
+*/
+#include "TimedThreadController.h"
+
+
+TimedThreadController::TimedThreadController() : ThreadController()
+{
+  reset();
+}
+
+void TimedThreadController::run() {
+  // Same as ThreadController::run, timing every pass and thread run
+  if (_onRun != NULL) _onRun();
+
+  const uint32_t passStartTime = micros();
+  const unsigned long time     = millis();
+  uint8_t slotIdx = 1;
+
+  for (int i = 0; i < MAX_THREADS; i++) {
+    if (!thread[i]) continue;
+
+    const bool tracked = slotIdx < THREAD_STATISTICS_SLOTS;
+
+    if (thread[i]->shouldRun(time)) {
+      // The interval that was due (the threads may change their own interval whilst running)
+      const uint32_t interval  = thread[i]->getInterval() * 1000;
+      const uint32_t startTime = micros();
+      thread[i]->run();
+      if (tracked) record(slotIdx, startTime, micros(), interval);
+    }
+
+    slotIdx++;
+  }
+
+  record(0, passStartTime, micros(), 0);
+  runned();
+}
+
+void TimedThreadController::sleepUntilDue() {
+#if IDLE_SLEEP_ENABLED
+  set_sleep_mode(SLEEP_MODE_IDLE);
+
+  // Interrupts are disabled whilst checking the threads, so that a wake-up interrupt cannot be missed before sleeping
+  noInterrupts();
+  if (isAnyThreadDue(millis())) {
+    interrupts();
+    return;
+  }
+
+  sleep_enable();
+  interrupts();   // The instruction that follows 'sei' is always executed before any pending interrupt
+  sleep_cpu();
+  sleep_disable();
+#endif
+}
+
+bool TimedThreadController::isAnyThreadDue(unsigned long time) {
+  for (int i = 0; i < MAX_THREADS; i++) {
+    if (thread[i] && thread[i]->shouldRun(time)) return true;
+  }
+  return false;
+}
+
+void TimedThreadController::reset() {
+  memset(statistics, 0, sizeof(statistics));
+  memset(averageTimes, 0, sizeof(averageTimes));
+
+  const uint32_t currentTime = micros();
+  for (uint8_t i = 0; i < THREAD_STATISTICS_SLOTS; i++) {
+    lastStartTimes[i] = currentTime;
+  }
+}
+
+uint8_t TimedThreadController::getStatisticsCount() {
+  return min(size() + 1, THREAD_STATISTICS_SLOTS);
+}
+
+ThreadStatistics& TimedThreadController::getStatistics(uint8_t slotIdx) {
+  return statistics[slotIdx];
+}
+
+void TimedThreadController::record(uint8_t slotIdx, uint32_t startTime, uint32_t endTime, uint32_t interval) {
+  ThreadStatistics& slot = statistics[slotIdx];
+  const uint32_t elapsed  = endTime - startTime;
+  const int32_t  lateness = startTime - (lastStartTimes[slotIdx] + interval);   // Negative if run early (ms resolution)
+  lastStartTimes[slotIdx] = startTime;
+
+  if (slot.runs < 0xFFFFFFFF) slot.runs++;
+  if (elapsed > slot.maxTime) slot.maxTime = min(elapsed, (uint32_t) 0xFFFF);
+
+  // Exponential moving average (1/16 weight), starting from the first run
+  averageTimes[slotIdx] = slot.runs == 1 ? elapsed << 4 : averageTimes[slotIdx] + elapsed - (averageTimes[slotIdx] >> 4);
+  slot.averageTime      = min(averageTimes[slotIdx] >> 4, (uint32_t) 0xFFFF);
+
+  uint8_t bucket = 0;
+  while (bucket < THREAD_LATENESS_BUCKETS - 1 && lateness >= (int32_t) (1000ul << bucket)) bucket++;
+  if (slot.lateness[bucket] < 0xFFFF) slot.lateness[bucket]++;
+}
@@ -0,0 +1,55 @@
+/*
+  TimedThreadController.h
+
+  ThreadController that keeps loop timing statistics (see ThreadStatistics) to check the timing headroom of the
+  threads, e.g. that the ElectrovalvesControlThread is serviced every millisecond.
+
+  Statistics slot 0 holds the statistics of the whole ThreadController pass, and the following slots hold the
+  statistics of each thread, in the order in which they were added. To keep the RAM usage bounded, only the first
+  THREAD_STATISTICS_SLOTS - 1 threads are tracked.
+  The lateness of a thread run is measured from the time it was due, i.e. its previous run start time plus its interval
+  (the delays are not accumulated, as the threads are rescheduled from the time they actually run). The passes have no
+  interval, so their lateness is the time elapsed since the previous pass started.
+  The statistics are not persisted, and are cleared on boot or with the RESET_THREAD_STATS_ADDR instruction.
+
+  If IDLE_SLEEP_ENABLED is set, 'sleepUntilDue' puts the CPU in the AVR idle sleep mode whilst no thread is due. The
+  timers and the UART keep running in idle mode, so the CPU is woken up by the next interrupt: the Timer0 overflow
+  (millis(), every ~1 ms, which bounds the sleep time to the next thread deadline) or a byte received by the UART.
+  As the loop passes only start once a thread is due, the pass lateness includes the time spent asleep.
+*/
+#ifndef TimedThreadController_h
+#define TimedThreadController_h
+
+#include <Arduino.h>
+#include <ThreadController.h>
+
+#include "../ControllerConfig.h"
+#include "../Communication/CommunicationsTypes.h"
+
+#if IDLE_SLEEP_ENABLED
+#include <avr/sleep.h>
+#endif
+
+class TimedThreadController: public ThreadController
+{
+    public:
+        TimedThreadController();
+
+        void run();
+        void sleepUntilDue();     // Sleeps until the next interrupt if no thread is due (IDLE_SLEEP_ENABLED)
+
+        void reset();
+
+        uint8_t getStatisticsCount();
+        ThreadStatistics& getStatistics(uint8_t slotIdx);
+
+    private:
+        ThreadStatistics statistics[THREAD_STATISTICS_SLOTS];
+        uint32_t         averageTimes[THREAD_STATISTICS_SLOTS];   // Moving averages (x16)
+        uint32_t         lastStartTimes[THREAD_STATISTICS_SLOTS];  // micros()
+
+        bool isAnyThreadDue(unsigned long time);
+        void record(uint8_t slotIdx, uint32_t startTime, uint32_t endTime, uint32_t interval);   // Interval in us
+};
+
+#endif
@@ -0,0 +1,114 @@
+/*
+  ChangeTracker.h
+
+  Keeps track of the changes of the PLC state fields.
+
+  A change version counter is incremented every time a field changes, and the field is tagged with the new version.
+  This allows the API server to request only the fields that have changed since the last version it has seen (see 
+  GET_CHANGES_SINCE_ADDR), instead of polling the last change timestamps and re-reading the entire PLC state.
+
+  The version is not persisted: it restarts from 1 (with every field tagged as changed) on boot, or whenever the
+  counter wraps around. A new session ID is therefore started each time (high byte: boot count persisted in the EEPROM,
+  low byte: wrap arounds since boot), and the session is sent with the version as a single 32-bit change version
+  (session << 16 | version). A change version from another session is treated as "every field has changed", so clients
+  do not need to detect the reboots themselves.
+*/
+#ifndef ChangeTracker_h
+#define ChangeTracker_h
+
+#include <Arduino.h>
+
+#include "../ControllerConfig.h"
+
+enum ChangeField : uint8_t {
+    // Global
+    CHANGE_FIELD_AUTO_MODE = 0,
+
+    // Swimming Pool
+    CHANGE_FIELD_SP_CONTROLLER_STATE,
+    CHANGE_FIELD_SP_PUMP_STATE,
+    CHANGE_FIELD_SP_UV_STATE,
+    CHANGE_FIELD_SP_PUMP_MANUAL_VALUE,
+    CHANGE_FIELD_SP_UV_ENABLE_VALUE,
+    CHANGE_FIELD_SP_FLOW_SENSOR_VALUE,
+    CHANGE_FIELD_SP_PUMP_MANUAL_DISABLE,
+    CHANGE_FIELD_SP_SCHEDULE_ENABLE,
+    CHANGE_FIELD_SP_SCHEDULE_NEXT,
+    CHANGE_FIELD_SP_SCHEDULE_DURATION,
+    CHANGE_FIELD_SP_SCHEDULE_PERIOD,
+
+    // Irrigation
+    CHANGE_FIELD_IRR_CONTROLLER_STATE,
+    CHANGE_FIELD_IRR_PUMP_STATE,
+    CHANGE_FIELD_IRR_MAINS_INLET_STATE,
+    CHANGE_FIELD_IRR_MANUAL_VALUE,
+    CHANGE_FIELD_IRR_PRESSURE_SENSOR_VALUE,
+    CHANGE_FIELD_IRR_MANUAL_DISABLE_STATE,
+    CHANGE_FIELD_IRR_ZONES_STATE,
+    CHANGE_FIELD_IRR_MANUAL_ZONES,
+    CHANGE_FIELD_IRR_MANUAL_SOURCE,
+    CHANGE_FIELD_IRR_SCHEDULE_ENABLE,
+    CHANGE_FIELD_IRR_SCHEDULE_PAUSED_STATE,
+    CHANGE_FIELD_IRR_SCHEDULE_RESUME_TIME,
+    CHANGE_FIELD_IRR_NEXT_IRRIGATION_TIME,
+    CHANGE_FIELD_IRR_SCHEDULE_GROUPS_STATE,
+    CHANGE_FIELD_IRR_DROPPED_JOBS,
+
+    // Irrigation groups (one field per group: CHANGE_FIELD_IRR_GROUP_0 + groupIdx)
+    CHANGE_FIELD_IRR_GROUP_0,
+
+    CHANGE_FIELDS_COUNT = CHANGE_FIELD_IRR_GROUP_0 + IRRIGATION_GROUPS_COUNT
+};
+
+class ChangeTracker
+{
+    public:
+        ChangeTracker(const uint8_t bootCount) : session(bootCount << 8) {
+            resetVersions();
+        }
+
+        void markChanged(const uint8_t field) {
+            if (field >= CHANGE_FIELDS_COUNT) return;
+
+            if (version == 0xFFFF) {
+                // Counter wrap around
+                session = (session & 0xFF00) | ((session + 1) & 0xFF);
+                resetVersions();
+            }
+            fieldVersions[field] = ++version;
+        }
+
+        // Mark the field as changed if the value differs from the last tracked value (for values which are not set by
+        // the PLC itself, e.g. input signals)
+        void trackValue(const uint8_t field, const bool value) {
+            const uint8_t mask = 1 << (field & 7);
+            if (((trackedValues[field >> 3] & mask) != 0) == value) return;
+
+            trackedValues[field >> 3] ^= mask;
+            markChanged(field);
+        }
+
+        uint32_t getVersion() {
+            return ((uint32_t) session << 16) | version;
+        }
+
+        bool hasChangedSince(const uint8_t field, const uint32_t sinceVersion) {
+            if ((sinceVersion >> 16) != session) return true;
+            return fieldVersions[field] > (uint16_t) sinceVersion;
+        }
+
+    private:
+        uint16_t session;
+        uint16_t version;
+        uint16_t fieldVersions[CHANGE_FIELDS_COUNT];
+        uint8_t  trackedValues[(CHANGE_FIELDS_COUNT + 7) / 8] = {0};
+
+        void resetVersions() {
+            version = 1;
+            for (uint8_t i = 0; i < CHANGE_FIELDS_COUNT; i++) {
+                fieldVersions[i] = version;
+            }
+        }
+};
+
+#endif
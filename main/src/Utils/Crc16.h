@@ -0,0 +1,28 @@
+/*
+  Crc16.h
+
+  CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF, no reflection, no final XOR).
+*/
+#ifndef Crc16_h
+#define Crc16_h
+
+#include <Arduino.h>
+
+#define CRC16_INITIAL_VALUE 0xFFFF
+
+inline uint16_t crc16Update(uint16_t crc, const uint8_t data) {
+    crc ^= ((uint16_t) data) << 8;
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+inline uint16_t crc16(const uint8_t* data, uint16_t size, uint16_t crc = CRC16_INITIAL_VALUE) {
+    for (uint16_t i = 0; i < size; i++) {
+        crc = crc16Update(crc, data[i]);
+    }
+    return crc;
+}
+
+#endif
@@ -14,18 +14,23 @@ const uint16_t TIME_OFFSET              = MAX_DURATION_OFFSET      + 2;
 const uint16_t NEXT_TIMESTAMP_OFFSET    = TIME_OFFSET              + 2;
 
 
+// The flag is a single byte (SwimmingPoolConfig_ADDR follows it)
 bool DataSaver::isInitialised() {
-  int initFlag;
-  EEPROM.get(INITIALISED_ADDR, initFlag);
-  return initFlag == INITIALISED_FLAG_VALUE;
+  return EEPROM.read(INITIALISED_ADDR) == INITIALISED_FLAG_VALUE;
 }
 
 void DataSaver::setInitialisedFlag() {
-  EEPROM.put(INITIALISED_ADDR, INITIALISED_FLAG_VALUE);
+  EEPROM.update(INITIALISED_ADDR, INITIALISED_FLAG_VALUE);
 }
 
 void DataSaver::resetInitialisedFlag() {
-  EEPROM.put(INITIALISED_ADDR, UNINITIALISED_FLAG_VALUE);
+  EEPROM.update(INITIALISED_ADDR, UNINITIALISED_FLAG_VALUE);
+}
+
+uint8_t DataSaver::incrementBootCount() {
+  const uint8_t bootCount = EEPROM.read(BOOT_COUNT_ADDR) + 1;
+  EEPROM.update(BOOT_COUNT_ADDR, bootCount);
+  return bootCount;
 }
 
 
@@ -94,3 +99,64 @@ void DataSaver::saveIrrigationGroupNextTimestamp(const uint8_t groupIdx, long ne
   const uint16_t saveAddrOffset = groupIdx * sizeof(IrrigationGroup) + NEXT_TIMESTAMP_OFFSET;
   EEPROM.put(IRRIGATION_GROUPS_ADDR + saveAddrOffset, nextTimestamp);
 }
+
+
+
+// Configuration Image **********************************************************************************************************
+
+void DataSaver::readConfigImage(const uint16_t offset, uint8_t* bufferPtr, const uint8_t bytesCount) {
+  ConfigImageHeader header;
+  if (offset < sizeof(ConfigImageHeader)) getConfigImageHeader(header);
+
+  for (uint16_t i = offset; i < offset + bytesCount && i < CONFIG_IMAGE_SIZE; i++) {
+    *(bufferPtr++) = i < sizeof(ConfigImageHeader) 
+      ? ((uint8_t*) &header)[i] 
+      : EEPROM.read(CONFIG_IMAGE_DATA_ADDR + i - sizeof(ConfigImageHeader));
+  }
+}
+
+bool DataSaver::stageConfigImage(const uint16_t offset, const uint8_t* dataPtr, const uint8_t bytesCount) {
+  if (offset + bytesCount > CONFIG_IMAGE_SIZE) return false;
+
+  for (uint8_t i = 0; i < bytesCount; i++) {
+    EEPROM.update(CONFIG_IMAGE_STAGING_ADDR + offset + i, dataPtr[i]);
+  }
+  return true;
+}
+
+bool DataSaver::commitConfigImage() {
+  ConfigImageHeader header;
+  EEPROM.get(CONFIG_IMAGE_STAGING_ADDR, header);
+
+  const int stagedDataAddr = CONFIG_IMAGE_STAGING_ADDR + sizeof(ConfigImageHeader);
+  if (
+    header.version != CONFIG_IMAGE_VERSION || 
+    header.size    != CONFIG_IMAGE_DATA_SIZE || 
+    header.crc     != getConfigDataCrc(stagedDataAddr)
+  ) return false;
+
+  // Only the bytes that differ are written
+  for (int i = 0; i < CONFIG_IMAGE_DATA_SIZE; i++) {
+    EEPROM.update(CONFIG_IMAGE_DATA_ADDR + i, EEPROM.read(stagedDataAddr + i));
+  }
+
+  // Invalidate the staged image, so that each import is committed once
+  EEPROM.update(CONFIG_IMAGE_STAGING_ADDR, 0);
+
+  setInitialisedFlag();
+  return true;
+}
+
+void DataSaver::getConfigImageHeader(ConfigImageHeader& header) {
+  header.version = CONFIG_IMAGE_VERSION;
+  header.size    = CONFIG_IMAGE_DATA_SIZE;
+  header.crc     = getConfigDataCrc(CONFIG_IMAGE_DATA_ADDR);
+}
+
+uint16_t DataSaver::getConfigDataCrc(const int dataAddr) {
+  uint16_t crc = CRC16_INITIAL_VALUE;
+  for (int i = 0; i < CONFIG_IMAGE_DATA_SIZE; i++) {
+    crc = crc16Update(crc, EEPROM.read(dataAddr + i));
+  }
+  return crc;
+}
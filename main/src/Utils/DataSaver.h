@@ -1,5 +1,12 @@
 /*
   DataSaver.h
+
+  Persists the controllers configuration in the EEPROM.
+
+  The whole persisted configuration can be exported and imported as a single configuration image, formed by a 
+  ConfigImageHeader followed by the EEPROM contents from SwimmingPoolConfig_ADDR to the end of the irrigation groups.
+  Imported images are written to a staging area (the EEPROM space right after the configuration) and only copied over
+  the live configuration once the whole image has been received and its header and CRC-16 have been validated.
 */
 #ifndef DataSaver_h
 #define DataSaver_h
@@ -8,6 +15,7 @@
 #include <EEPROM.h>
 
 #include "../ControllerConfig.h"
+#include "Crc16.h"
 #include "../Irrigation/IrrigationControllerTypes.h"
 #include "../Irrigation/ElectrovalvesControlThread.h"
 #include "../SwimmingPool/SwimmingPoolControllerTypes.h"
@@ -22,6 +30,25 @@ const int IRRIGATION_MANUAL_CONFIG_ADDR   = SwimmingPoolSchedule_ADDR + sizeof(S
 const int IRRIGATION_SCHEDULE_CONFIG_ADDR = IRRIGATION_MANUAL_CONFIG_ADDR + sizeof(IrrigationManualConfig);
 const int IRRIGATION_GROUPS_ADDR          = IRRIGATION_SCHEDULE_CONFIG_ADDR + sizeof(IrrigationScheduleConfig);
 
+// Configuration image
+#define CONFIG_IMAGE_VERSION 1  // Must be incremented whenever the layout of the persisted configuration changes
+
+struct __attribute__((packed)) ConfigImageHeader {
+    uint8_t  version;   // CONFIG_IMAGE_VERSION
+    uint16_t size;      // Size of the configuration data that follows the header
+    uint16_t crc;       // CRC-16 of the configuration data
+};
+
+const int CONFIG_IMAGE_DATA_ADDR    = SwimmingPoolConfig_ADDR;
+const int CONFIG_IMAGE_DATA_SIZE    = IRRIGATION_GROUPS_ADDR + sizeof(IrrigationGroups) - CONFIG_IMAGE_DATA_ADDR;
+const int CONFIG_IMAGE_SIZE         = sizeof(ConfigImageHeader) + CONFIG_IMAGE_DATA_SIZE;
+const int CONFIG_IMAGE_STAGING_ADDR = CONFIG_IMAGE_DATA_ADDR + CONFIG_IMAGE_DATA_SIZE;
+
+// Boot counter (not part of the configuration image)
+const int BOOT_COUNT_ADDR = CONFIG_IMAGE_STAGING_ADDR + CONFIG_IMAGE_SIZE;
+
+static_assert(BOOT_COUNT_ADDR + 1 <= E2END + 1, "The EEPROM must fit the configuration image staging area and the boot counter");
+
 class DataSaver
 {
     public:
@@ -29,6 +56,8 @@ class DataSaver
         void setInitialisedFlag();
         void resetInitialisedFlag();
 
+        uint8_t incrementBootCount();   // Returns the new count (wraps around), which identifies the current boot
+
         // Swimming Pool
         void getSwimmingPoolConfig(SwimmingPoolConfig& config);
         void saveSwimmingPoolConfig(const SwimmingPoolConfig& config);
@@ -50,6 +79,15 @@ class DataSaver
         void saveIrrigationGroup(const uint8_t groupIdx, IrrigationGroup& irrigationGroup);
 
         void saveIrrigationGroupNextTimestamp(const uint8_t groupIdx, long nextTimestamp);
+
+        // Configuration Image
+        void readConfigImage(const uint16_t offset, uint8_t* bufferPtr, const uint8_t bytesCount);
+        bool stageConfigImage(const uint16_t offset, const uint8_t* dataPtr, const uint8_t bytesCount);  // Returns false if the data exceeds the image
+        bool commitConfigImage();   // Returns false if the staged image is not valid (the live configuration is left untouched)
+
+    private:
+        void     getConfigImageHeader(ConfigImageHeader& header);
+        uint16_t getConfigDataCrc(const int dataAddr);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,69 @@
+/*
+  DeadlineIndex.h
+
+  Keeps a set of items (identified by their index, 0 to N-1) sorted by deadline, so that the earliest deadline can be
+  checked in constant time instead of scanning every item on each tick. Items with the same deadline are sorted by
+  index.
+  Updates are done by insertion (O(N)), and only need to be done when an item deadline changes.
+*/
+#ifndef DeadlineIndex_h
+#define DeadlineIndex_h
+
+#include <Arduino.h>
+
+#define DEADLINE_INDEX_NONE 0xFFFFFFFF  // First deadline of an empty index
+
+template <uint8_t N>
+class DeadlineIndex
+{
+    public:
+        // Adds the item, or moves it if it was already in the index
+        void set(const uint8_t id, const uint32_t deadline) {
+            remove(id);
+
+            uint8_t i = count++;
+            while (i > 0 && (deadlines[i - 1] > deadline || (deadlines[i - 1] == deadline && ids[i - 1] > id))) {
+                ids[i]       = ids[i - 1];
+                deadlines[i] = deadlines[i - 1];
+                i--;
+            }
+
+            ids[i]       = id;
+            deadlines[i] = deadline;
+        }
+
+        void remove(const uint8_t id) {
+            uint8_t i = 0;
+            while (i < count && ids[i] != id) i++;
+            if (i == count) return;
+
+            count--;
+            for (; i < count; i++) {
+                ids[i]       = ids[i + 1];
+                deadlines[i] = deadlines[i + 1];
+            }
+        }
+
+        void clear() {
+            count = 0;
+        }
+
+        bool isEmpty() {
+            return count == 0;
+        }
+
+        uint8_t getFirst() {
+            return ids[0];
+        }
+
+        uint32_t getFirstDeadline() {
+            return count == 0 ? DEADLINE_INDEX_NONE : deadlines[0];
+        }
+
+    private:
+        uint8_t  ids[N];
+        uint32_t deadlines[N];
+        uint8_t  count = 0;
+};
+
+#endif
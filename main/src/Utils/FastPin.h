@@ -0,0 +1,93 @@
+/*
+  FastPin.h
+
+  Direct port register access to the digital outputs, instead of digitalWrite (which looks up the pin in the core pin
+  tables and disables the interrupts on every call).
+
+  The Arduino Nano (ATmega328P) pins are mapped to their port and bit at compile time: D0-D7 are PORTD0-7, D8-D13 are
+  PORTB0-5 and D14-D19 (A0-A5) are PORTC0-5 (A6/A7 are analog inputs only). Several pins of the same port can therefore
+  be written at once with a single (atomic) port write, e.g. the multiplexer address, so that all the pins change at the
+  same time.
+  'OutputBatch' collects the writes to several pins and commits them with one write per port.
+
+  On other boards (and in the host simulation) the writes fall back to digitalWrite.
+*/
+#ifndef FastPin_h
+#define FastPin_h
+
+#include <Arduino.h>
+
+#if defined(__AVR_ATmega328P__)
+#define FAST_PIN_ENABLED 1
+#else
+#define FAST_PIN_ENABLED 0
+#endif
+
+#define FAST_PIN_PORT_B 0
+#define FAST_PIN_PORT_C 1
+#define FAST_PIN_PORT_D 2
+#define FAST_PIN_PORTS  3
+
+constexpr uint8_t fastPinPort(const uint8_t pin) {
+    return pin < 8 ? FAST_PIN_PORT_D : pin < 14 ? FAST_PIN_PORT_B : FAST_PIN_PORT_C;
+}
+
+constexpr uint8_t fastPinBit(const uint8_t pin) {
+    return pin < 8 ? pin : pin < 14 ? pin - 8 : pin - 14;
+}
+
+constexpr uint8_t fastPinMask(const uint8_t pin) {
+    return 1 << fastPinBit(pin);
+}
+
+// Sets the pins of 'mask' in the port to the bits of 'value' at once (safe to call from interrupts)
+inline void fastPortWrite(const uint8_t port, const uint8_t mask, const uint8_t value) {
+#if FAST_PIN_ENABLED
+    volatile uint8_t& portRegister = port == FAST_PIN_PORT_B ? PORTB : port == FAST_PIN_PORT_C ? PORTC : PORTD;
+
+    const uint8_t oldSREG = SREG;
+    cli();
+    portRegister = (portRegister & ~mask) | (value & mask);
+    SREG = oldSREG;
+#else
+    const uint8_t firstPin = port == FAST_PIN_PORT_B ? 8 : port == FAST_PIN_PORT_C ? 14 : 0;
+
+    for (uint8_t i = 0; i < 8; i++) {
+        if ((mask & _BV(i)) != 0) digitalWrite(firstPin + i, (value & _BV(i)) != 0);
+    }
+#endif
+}
+
+inline void fastPinWrite(const uint8_t pin, const bool value) {
+    fastPortWrite(fastPinPort(pin), fastPinMask(pin), value ? 0xFF : 0);
+}
+
+
+class OutputBatch
+{
+    public:
+        void write(const uint8_t pin, const bool value) {
+            const uint8_t port = fastPinPort(pin);
+            const uint8_t mask = fastPinMask(pin);
+
+            masks[port] |= mask;
+            if (value) values[port] |= mask;
+            else       values[port] &= ~mask;
+        }
+
+        // Writes the pending pin states, one port at a time
+        void commit() {
+            for (uint8_t port = 0; port < FAST_PIN_PORTS; port++) {
+                if (masks[port] == 0) continue;
+
+                fastPortWrite(port, masks[port], values[port]);
+                masks[port] = 0;
+            }
+        }
+
+    private:
+        uint8_t masks[FAST_PIN_PORTS]  = {0};   // Pins written since the last commit
+        uint8_t values[FAST_PIN_PORTS] = {0};
+};
+
+#endif
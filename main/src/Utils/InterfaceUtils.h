@@ -6,6 +6,8 @@
 
 #include <Arduino.h>
 
+#include "FastPin.h"
+
 #define ANALOG_PIN_HIGH_THRESHOLD 800 // TODO CHECK VALUE
 #define DEBOUNCE_TIME_MILLIS 200
 
@@ -55,14 +57,13 @@ class OutputRelay
             setPinMode();
         }
 
-        void turnOn() {            
-            digitalWrite(pinRef, HIGH);
-            state = true;
+        // If a batch is given, the relay is only switched once the batch is committed (getState already returns the new state)
+        void turnOn(OutputBatch* batch = nullptr) {
+            setState(true, batch);
         }
 
-        void turnOff() {            
-            digitalWrite(pinRef, LOW);
-            state = false;
+        void turnOff(OutputBatch* batch = nullptr) {
+            setState(false, batch);
         }
 
         bool getState() {
@@ -77,6 +78,12 @@ class OutputRelay
             pinMode(pinRef, OUTPUT);
         }
 
+        void setState(const bool newState, OutputBatch* batch) {
+            if (batch != nullptr) batch->write(pinRef, newState);
+            else                  fastPinWrite(pinRef, newState);
+            state = newState;
+        }
+
 };
 
 
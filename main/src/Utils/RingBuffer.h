@@ -0,0 +1,97 @@
+/*
+  RingBuffer.h
+
+  Fixed-capacity FIFO queue of N items, statically allocated (no heap allocation, which fragments the small RAM of the
+  board). Items are pushed at the back and popped from the front in constant time, and 'push' returns false instead of
+  overwriting the oldest item when the queue is full, so that the caller can report the overflow.
+  'get(i)' returns the ith item from the front (0 being the next item to be popped). Items can also be inserted at any
+  position with 'insert' and removed from any position with 'remove' (O(N)), to keep the queue in a custom order.
+*/
+#ifndef RingBuffer_h
+#define RingBuffer_h
+
+#include <Arduino.h>
+
+template <typename T, uint8_t N>
+class RingBuffer
+{
+    public:
+        bool push(const T& item) {
+            if (count >= N) return false;
+
+            items[(head + count) % N] = item;
+            count++;
+            return true;
+        }
+
+        // Inserts the item before the ith item (i = size() to push it), returns false if full
+        bool insert(const uint8_t i, const T& item) {
+            if (count >= N || i > count) return false;
+
+            for (uint8_t j = count; j > i; j--) {
+                get(j) = get(j - 1);
+            }
+            get(i) = item;
+            count++;
+            return true;
+        }
+
+        // Removes the ith item (no-op if out of range)
+        void remove(const uint8_t i) {
+            if (i >= count) return;
+
+            count--;
+            for (uint8_t j = i; j < count; j++) {
+                get(j) = get(j + 1);
+            }
+        }
+
+        // Removes the front item (no-op if empty)
+        void pop() {
+            if (count == 0) return;
+
+            head = (head + 1) % N;
+            count--;
+        }
+
+        // Removes the front item into 'item', returns false if empty
+        bool shift(T& item) {
+            if (count == 0) return false;
+
+            item = items[head];
+            pop();
+            return true;
+        }
+
+        void clear() {
+            head  = 0;
+            count = 0;
+        }
+
+        T& get(const uint8_t i) {
+            return items[(head + i) % N];
+        }
+
+        T& back() {
+            return get(count - 1);
+        }
+
+        uint8_t size() {
+            return count;
+        }
+
+        bool isEmpty() {
+            return count == 0;
+        }
+
+        bool isFull() {
+            return count >= N;
+        }
+
+    private:
+        T       items[N];
+        uint8_t head  = 0;
+        uint8_t count = 0;
+};
+
+#endif
@@ -0,0 +1,75 @@
+/*
+  Timebase.h
+
+  Provides the current time (UNIX timestamp) to every module without reading the RTC on each call.
+
+  Reading the DS3231 is an I2C transaction of several hundred microseconds, followed by a DateTime conversion. The RTC
+  is therefore only read every TIMEBASE_SYNC_INTERVAL, and the time is interpolated with millis() in between, from an
+  anchor: the estimated millis() value at which the RTC ticked into a given second.
+  Every sync checks the interpolated time against the RTC, and moves the anchor when they disagree (drift correction):
+    - RTC ahead:  the RTC second started at or before the sync, the anchor is moved back to the sync time
+    - RTC behind: the next RTC second has not started yet, the anchor is moved forward to one second before the sync
+  The drift of the millis() clock (ceramic resonator) therefore never accumulates, and the anchor converges towards
+  the actual RTC second boundaries. The returned time never goes backwards between syncs; only 'adjust' can set the
+  time back.
+*/
+#ifndef Timebase_h
+#define Timebase_h
+
+#include <Arduino.h>
+#include <RTClib.h>
+
+#include "../ControllerConfig.h"
+
+class Timebase
+{
+    public:
+        Timebase(RTC_DS3231& rtcClock) : clock(rtcClock) {
+            sync();
+        }
+
+        uint32_t now() {
+            if (millis() - syncMillis >= TIMEBASE_SYNC_INTERVAL) sync();
+
+            const uint32_t time = anchorTime + (millis() - anchorMillis) / 1000;
+            if (time > lastTime) lastTime = time;
+            return lastTime;
+        }
+
+        // Sets the RTC time, and resyncs at once
+        void adjust(const uint32_t time) {
+            clock.adjust(DateTime(time));
+            lastTime = 0;
+            sync();
+        }
+
+    private:
+        RTC_DS3231& clock;
+
+        uint32_t anchorTime   = 0;  // RTC second of the anchor
+        uint32_t anchorMillis = 0;  // Estimated millis() at the start of the anchor second
+        uint32_t syncMillis   = 0;  // millis() on the last sync
+        uint32_t lastTime     = 0;  // Last returned time
+
+        void sync() {
+            const uint32_t time          = clock.now().unixtime();
+            const uint32_t currentMillis = millis();
+            const uint32_t predictedTime = anchorTime + (currentMillis - anchorMillis) / 1000;
+
+            if (time == predictedTime) {
+                // Keep the anchor phase, only move it to the current second
+                anchorMillis += (time - anchorTime) * 1000;
+            }
+            else if (time > predictedTime) {
+                anchorMillis = currentMillis;
+            }
+            else {
+                anchorMillis = currentMillis - 999;
+            }
+
+            anchorTime = time;
+            syncMillis = currentMillis;
+        }
+};
+
+#endif
@@ -0,0 +1,269 @@
+/*
+  HostArduino.cpp
+
+  Implementation of the Arduino core/library stubs and of the simulated environment (see HostSimulation.h).
+*/
+#include "HostSimulation.h"
+
+#include <EEPROM.h>
+#include <RTClib.h>
+
+#define HOST_PINS_COUNT 22
+
+HardwareSerial Serial;
+EEPROMClass    EEPROM;
+
+static uint64_t currentMicros = 0;
+
+static bool                nodeAsleep      = false;   // Set by 'sleep_cpu' until the next simulation step
+static HostPowerStatistics powerStatistics = {};
+
+
+
+// Bus **************************************************************************************************************************
+
+struct BusByte {
+    uint64_t start;
+    uint64_t end;
+    uint8_t  value;
+    bool     fromNode;
+    bool     corrupted;
+};
+
+static std::deque<BusByte> busBytes;              // Bytes being transmitted (or waiting to be transmitted)
+static std::deque<uint8_t> nodeRxBuffer;
+static std::deque<uint8_t> clientRxBuffer;
+
+static uint32_t byteTime              = 521;      // 10 bits at 19200 baud
+static uint64_t nodeLineFreeTime      = 0;
+static uint64_t clientLineFreeTime    = 0;
+static uint64_t lastNodeByteTime      = 0;
+static bool     nodeTransmitEnabled   = false;
+
+static HostBusStatistics busStatistics = {};
+
+static void deliverBusBytes() {
+    while (!busBytes.empty() && busBytes.front().end <= currentMicros) {
+        const BusByte busByte = busBytes.front();
+        busBytes.pop_front();
+
+        // Corrupted bytes are received as garbage
+        const uint8_t value = busByte.corrupted ? busByte.value ^ 0x5A : busByte.value;
+
+        if (busByte.fromNode) {
+            clientRxBuffer.push_back(value);
+            lastNodeByteTime = busByte.end;
+        }
+        else if (!nodeTransmitEnabled) { // The MAX485 receiver is disabled whilst transmitting
+            if (nodeRxBuffer.size() < SERIAL_RX_BUFFER_SIZE - 1) nodeRxBuffer.push_back(value);
+            else busStatistics.nodeRxOverruns++;
+        }
+    }
+}
+
+static uint64_t transmitByte(const uint8_t value, const bool fromNode) {
+    uint64_t& lineFreeTime = fromNode ? nodeLineFreeTime : clientLineFreeTime;
+
+    BusByte busByte;
+    busByte.start     = max(currentMicros, lineFreeTime);
+    busByte.end       = busByte.start + byteTime;
+    busByte.value     = value;
+    busByte.fromNode  = fromNode;
+    busByte.corrupted = false;
+
+    lineFreeTime = busByte.end;
+
+    // Check for collisions with the bytes transmitted by the other end
+    for (BusByte& other : busBytes) {
+        if (other.fromNode != fromNode && other.start < busByte.end && busByte.start < other.end) {
+            if (!other.corrupted) busStatistics.collisions++;
+            other.corrupted   = true;
+            busByte.corrupted = true;
+        }
+    }
+    if (busByte.corrupted) busStatistics.collisions++;
+
+    // Keep the bytes sorted by transmission end time
+    auto position = busBytes.end();
+    while (position != busBytes.begin() && (position - 1)->end > busByte.end) position--;
+    busBytes.insert(position, busByte);
+
+    return busByte.end;
+}
+
+void hostSetTransmitEnable(bool enabled) {
+    nodeTransmitEnabled = enabled;
+}
+
+void hostSetBaudRate(uint32_t baudRate) {
+    byteTime = (10 * 1000000UL + baudRate - 1) / baudRate;
+}
+
+uint32_t hostByteTime() {
+    return byteTime;
+}
+
+uint64_t hostClientWrite(uint8_t byte) {
+    busStatistics.clientBytesSent++;
+    return transmitByte(byte, false);
+}
+
+int hostClientRead() {
+    if (clientRxBuffer.empty()) return -1;
+
+    const uint8_t value = clientRxBuffer.front();
+    clientRxBuffer.pop_front();
+    return value;
+}
+
+bool hostBusBusy() {
+    for (const BusByte& busByte : busBytes) {
+        if (busByte.start <= currentMicros) return true;
+    }
+    return false;
+}
+
+uint64_t hostLastNodeByteTime() {
+    return lastNodeByteTime;
+}
+
+const HostBusStatistics& hostBusStatistics() {
+    return busStatistics;
+}
+
+
+
+// Serial ***********************************************************************************************************************
+
+static int nodeTxBufferedBytes() {
+    // Bytes written by the PLC that have not started to be transmitted yet
+    int count = 0;
+    for (const BusByte& busByte : busBytes) {
+        if (busByte.fromNode && busByte.start > currentMicros) count++;
+    }
+    return count;
+}
+
+void HardwareSerial::begin(unsigned long baud, uint8_t /* config */) {
+    hostSetBaudRate(baud);
+}
+
+int HardwareSerial::available() {
+    return nodeRxBuffer.size();
+}
+
+int HardwareSerial::read() {
+    if (nodeRxBuffer.empty()) return -1;
+
+    const uint8_t value = nodeRxBuffer.front();
+    nodeRxBuffer.pop_front();
+    return value;
+}
+
+int HardwareSerial::availableForWrite() {
+    return SERIAL_TX_BUFFER_SIZE - 1 - nodeTxBufferedBytes();
+}
+
+size_t HardwareSerial::write(uint8_t byte) {
+    // Block until there is space in the Tx buffer
+    while (availableForWrite() <= 0) hostAdvance(byteTime);
+
+    busStatistics.nodeBytesSent++;
+    if (nodeTransmitEnabled) transmitByte(byte, true);
+    else nodeLineFreeTime = max(currentMicros, nodeLineFreeTime) + byteTime; // The MAX485 driver is disabled
+    return 1;
+}
+
+void HardwareSerial::flush() {
+    if (nodeLineFreeTime > currentMicros) hostAdvance(nodeLineFreeTime - currentMicros);
+}
+
+
+
+// Clock ************************************************************************************************************************
+
+uint64_t hostMicros() {
+    return currentMicros;
+}
+
+void hostAdvance(uint64_t micros) {
+    if (nodeAsleep) powerStatistics.asleepMicros += micros;
+    else            powerStatistics.awakeMicros  += micros;
+    nodeAsleep = false;
+
+    currentMicros += micros;
+    deliverBusBytes();
+}
+
+unsigned long millis() {
+    return (unsigned long) (currentMicros / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long) currentMicros;
+}
+
+void delay(unsigned long ms) {
+    hostAdvance((uint64_t) ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    hostAdvance(us);
+}
+
+
+
+// Power ************************************************************************************************************************
+
+void hostSleep() {
+    nodeAsleep = true;
+    powerStatistics.sleeps++;
+}
+
+const HostPowerStatistics& hostPowerStatistics() {
+    return powerStatistics;
+}
+
+
+
+// Pins *************************************************************************************************************************
+
+static uint8_t pinModes[HOST_PINS_COUNT]     = {0};
+static uint8_t digitalValues[HOST_PINS_COUNT] = {0};
+static int     analogValues[HOST_PINS_COUNT]  = {0};
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < HOST_PINS_COUNT) pinModes[pin] = mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin < HOST_PINS_COUNT) digitalValues[pin] = val;
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < HOST_PINS_COUNT ? digitalValues[pin] : LOW;
+}
+
+int analogRead(uint8_t pin) {
+    return pin < HOST_PINS_COUNT ? analogValues[pin] : 0;
+}
+
+void hostSetAnalogInput(uint8_t pin, int value) {
+    if (pin < HOST_PINS_COUNT) analogValues[pin] = value;
+}
+
+
+
+// RTC **************************************************************************************************************************
+
+static uint32_t rtcAdjustedTime   = 1654041600;    // 2022-06-01 00:00:00
+static uint64_t rtcAdjustedMicros = 0;
+
+uint32_t hostRtcTime() {
+    return rtcAdjustedTime + (uint32_t) ((currentMicros - rtcAdjustedMicros) / 1000000);
+}
+
+void hostRtcAdjust(uint32_t time) {
+    rtcAdjustedTime   = time;
+    rtcAdjustedMicros = currentMicros;
+}
@@ -0,0 +1,51 @@
+/*
+  HostSimulation.h
+
+  Simulated environment used to run the firmware on a Linux host (see HostArduino.cpp):
+    - A simulated clock (millis/micros) that only advances when the simulation advances it. Blocking calls of the
+      firmware (delay/delayMicroseconds, blocking serial writes) advance the clock by the time they would take.
+    - An RS485 bus between the PLC (COMM_SERIAL + MAX485) and a simulated client. Bytes take the transmission time of
+      the configured baud rate to be delivered, the PLC serial Rx/Tx buffers have the size of the Arduino core buffers,
+      and bytes transmitted by both ends at the same time are corrupted (collision).
+    - The digital/analog pins, the EEPROM and the DS3231 RTC (which counts the simulated time).
+    - The AVR idle sleep: the simulation step that follows a 'sleep_cpu' call is accounted as time spent asleep.
+*/
+#ifndef HostSimulation_h
+#define HostSimulation_h
+
+#include <Arduino.h>
+
+struct HostBusStatistics {
+    uint32_t nodeBytesSent;
+    uint32_t clientBytesSent;
+    uint32_t collisions;            // Bytes corrupted because both ends were transmitting at the same time
+    uint32_t nodeRxOverruns;        // Bytes lost because the PLC serial Rx buffer was full
+};
+
+struct HostPowerStatistics {
+    uint64_t asleepMicros;
+    uint64_t awakeMicros;
+    uint32_t sleeps;                // 'sleep_cpu' calls
+};
+
+// Clock
+uint64_t hostMicros();
+void     hostAdvance(uint64_t micros);   // Advances the simulated clock (delivering the bytes on the bus)
+
+// Bus
+void     hostSetBaudRate(uint32_t baudRate);
+uint32_t hostByteTime();                 // Transmission time of a byte in microseconds
+uint64_t hostClientWrite(uint8_t byte);  // Returns the time at which the byte will have been transmitted
+int      hostClientRead();               // Returns -1 if no byte has been received
+bool     hostBusBusy();                  // True while a byte is being transmitted
+uint64_t hostLastNodeByteTime();         // Time at which the last PLC byte was delivered to the client
+const HostBusStatistics& hostBusStatistics();
+
+// Power
+void     hostSleep();
+const HostPowerStatistics& hostPowerStatistics();
+
+// Pins
+void     hostSetAnalogInput(uint8_t pin, int value);
+
+#endif
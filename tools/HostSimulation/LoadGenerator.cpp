@@ -0,0 +1,427 @@
+/*
+  LoadGenerator.cpp
+
+  Protocol load generator and latency benchmark. Runs the firmware sketch (main.ino) on the simulated host environment
+  (see HostSimulation.h), and acts as the API server on the other end of the simulated RS485 bus:
+    - Requests are generated with exponentially distributed inter-arrival times at the configured rate, picking the 
+      instruction from every instruction defined in ProtocolDefinition.h/InstructionTable.cpp ('all' mix: read 
+      instructions are 10 times more likely than write instructions), or from the read instructions only ('poll' mix).
+    - Requests are sent as sequenced CRC-16 frames, with up to 'window' requests in flight. A new request is only sent 
+      while the bus is idle, either when no request is in flight or right after the previous request (as a burst).
+    - Requests not responded within the timeout are counted as dropped, and the requests still waiting to be sent at the
+      end of the run (when the offered load exceeds the throughput) are counted as unsent.
+
+  Each tick of the simulation runs the sketch loop once and then advances the simulated clock by 'tick-us'.
+  The turnaround time is measured from the end of the request frame to the end of the response frame, and the 
+  latency from the time the request was generated to the end of the response frame.
+
+  Usage: loadgen [--rate <requests/s>] [--duration <s>] [--window <requests>] [--mix all|poll] [--timeout <ms>]
+                 [--tick-us <us>] [--seed <seed>]
+*/
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+
+#include "HostSimulation.h"
+
+#include <RTClib.h>
+
+#include "src/ControllerConfig.h"
+#include "src/Utils/Crc16.h"
+#include "src/Communication/ProtocolDefinition.h"
+#include "src/Communication/InstructionTable.h"
+
+void setup();
+void loop();
+
+struct Options {
+    double   rate     = 20;
+    double   duration = 60;
+    uint8_t  window   = 1;
+    bool     pollOnly = false;
+    uint32_t timeout  = 250;
+    uint32_t tickUs   = 100;
+    uint32_t seed     = 1;
+};
+
+struct Operation {
+    InstructionDefinition definition;
+    uint32_t              weight;
+};
+
+struct PendingRequest {
+    uint64_t             generatedTime;
+    std::vector<uint8_t> frame;
+};
+
+struct InFlightRequest {
+    uint8_t  code;
+    uint64_t generatedTime;
+    uint64_t sentTime;          // End of the request frame
+};
+
+struct Results {
+    uint32_t generated  = 0;
+    uint32_t sent       = 0;
+    uint32_t completed  = 0;
+    uint32_t naks       = 0;
+    uint32_t dropped    = 0;
+    uint32_t unsent     = 0;    // Generated requests still pending at the end of the run
+    uint32_t corrupted  = 0;    // Response frames that failed the CRC check
+    uint32_t unmatched  = 0;    // Response frames whose sequence number does not match any request in flight
+    size_t   maxPending = 0;
+
+    std::vector<uint64_t> turnaroundTimes;
+    std::vector<uint64_t> latencyTimes;
+    std::map<uint8_t, uint32_t> nakReasons;
+};
+
+static Options                          options;
+static Results                          results;
+static HostPowerStatistics              setupPower      = {};
+static std::mt19937                     randomGenerator;
+static std::vector<Operation>           operations;
+static std::deque<PendingRequest>       pendingRequests;
+static std::map<uint8_t, InFlightRequest> inFlightRequests;   // By sequence number
+static uint8_t                          nextSequence    = 0;
+static uint64_t                         lastClientByte  = 0;  // Time at which the last request byte is transmitted
+static uint32_t                         changeVersion   = 0;  // Last GET_CHANGES_SINCE_ADDR version
+
+
+
+// Options **********************************************************************************************************************
+
+static void printUsage() {
+    printf(
+        "Usage: loadgen [--rate <requests/s>] [--duration <s>] [--window <requests>] [--mix all|poll] [--timeout <ms>]\n"
+        "               [--tick-us <us>] [--seed <seed>]\n"
+    );
+}
+
+static bool parseOptions(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const std::string option = argv[i];
+        if (option == "--help") return false;
+        if (i + 1 >= argc) return false;
+
+        const char* value = argv[++i];
+        if      (option == "--rate")     options.rate     = atof(value);
+        else if (option == "--duration") options.duration = atof(value);
+        else if (option == "--window")   options.window   = max(1, min(COMM_RX_QUEUE_LENGTH, atoi(value)));
+        else if (option == "--mix")      options.pollOnly = std::string(value) == "poll";
+        else if (option == "--timeout")  options.timeout  = atoi(value);
+        else if (option == "--tick-us")  options.tickUs   = max(1, atoi(value));
+        else if (option == "--seed")     options.seed     = atoi(value);
+        else return false;
+    }
+    return options.rate > 0 && options.duration > 0;
+}
+
+
+
+// Request generation ***********************************************************************************************************
+
+static void loadOperations() {
+    // Every instruction defined in the instruction table
+    for (uint16_t code = 0; code < FRAME_NAK_CODE; code++) {
+        Operation operation;
+        if (!findInstruction(code, operation.definition)) continue;
+
+        const uint8_t flags = operation.definition.flags;
+        if (options.pollOnly && flags != INSTRUCTION_READ && code != BATCH_ADDR) continue;
+
+        operation.weight = (flags & INSTRUCTION_WRITE) && code != BATCH_ADDR ? 1 : 10;
+        operations.push_back(operation);
+    }
+}
+
+static const Operation& pickOperation(bool readOnly, bool fixedSizeOnly) {
+    uint32_t totalWeight = 0;
+    for (const Operation& operation : operations) totalWeight += operation.weight;
+
+    while (true) {
+        uint32_t target = std::uniform_int_distribution<uint32_t>(0, totalWeight - 1)(randomGenerator);
+        for (const Operation& operation : operations) {
+            if (target < operation.weight) {
+                const InstructionDefinition& definition = operation.definition;
+                if (readOnly && definition.flags != INSTRUCTION_READ) break;
+                if (fixedSizeOnly && definition.requestSize == INSTRUCTION_VARIABLE_SIZE) break;
+                return operation;
+            }
+            target -= operation.weight;
+        }
+    }
+}
+
+static uint8_t randomByte() {
+    return std::uniform_int_distribution<uint16_t>(0, 0xFF)(randomGenerator);
+}
+
+static void appendPayload(std::vector<uint8_t>& payload, const InstructionDefinition& definition) {
+    switch (definition.code) {
+        case SET_CLOCK_ADDR: {
+            const uint32_t time = hostRtcTime();
+            payload.insert(payload.end(), (const uint8_t*) &time, (const uint8_t*) &time + 4);
+            return;
+        }
+
+        case GET_CHANGES_SINCE_ADDR:
+            payload.insert(payload.end(), (const uint8_t*) &changeVersion, (const uint8_t*) &changeVersion + 4);
+            payload.push_back(0);
+            return;
+
+        case GET_IF_CHANGED_ADDR: {
+            // A fixed size read instruction, checked against the last version seen
+            const InstructionDefinition& subDefinition = pickOperation(true, true).definition;
+            payload.insert(payload.end(), (const uint8_t*) &changeVersion, (const uint8_t*) &changeVersion + 4);
+            payload.push_back(subDefinition.code);
+            appendPayload(payload, subDefinition);
+            return;
+        }
+
+        case STAGE_CONFIG_IMAGE_ADDR:
+            // Invalid image version, so that the following commits are rejected and the configuration is kept
+            payload.push_back(0);
+            payload.push_back(0);
+            payload.push_back(0);
+            return;
+
+        case IRR_GET_SCHEDULE_GROUPS_ADDR:
+            payload.push_back(0);
+            payload.push_back(IRRIGATION_GROUPS_COUNT);
+            return;
+
+        case BATCH_ADDR: {
+            // 2 to 4 fixed size read instructions
+            const uint8_t count = std::uniform_int_distribution<uint16_t>(2, 4)(randomGenerator);
+            for (uint8_t i = 0; i < count; i++) {
+                const InstructionDefinition& subDefinition = pickOperation(true, true).definition;
+                payload.push_back(subDefinition.code);
+                payload.push_back(subDefinition.requestSize);
+                appendPayload(payload, subDefinition);
+            }
+            return;
+        }
+    }
+
+    if (definition.requestSize == INSTRUCTION_VARIABLE_SIZE) return;
+
+    // The first byte is the group index for the irrigation group instructions
+    for (uint8_t i = 0; i < definition.requestSize; i++) {
+        payload.push_back(i == 0 ? randomByte() % IRRIGATION_GROUPS_COUNT : randomByte());
+    }
+}
+
+static void generateRequest() {
+    const InstructionDefinition& definition = pickOperation(false, false).definition;
+
+    std::vector<uint8_t> payload;
+    appendPayload(payload, definition);
+
+    PendingRequest request;
+    request.generatedTime = hostMicros();
+    request.frame         = { definition.code, (uint8_t) payload.size() };
+    request.frame.insert(request.frame.end(), payload.begin(), payload.end());
+
+    pendingRequests.push_back(request);
+    results.generated++;
+    results.maxPending = max(results.maxPending, pendingRequests.size());
+}
+
+
+
+// Client ***********************************************************************************************************************
+
+static bool canSendRequest() {
+    if (pendingRequests.empty() || inFlightRequests.size() >= options.window) return false;
+    if (hostBusBusy()) return false;
+
+    // Only send requests back to back (before the PLC starts responding), or once every response has been received
+    return inFlightRequests.empty() || hostMicros() <= lastClientByte + 500;
+}
+
+static void sendRequest() {
+    PendingRequest request = pendingRequests.front();
+    pendingRequests.pop_front();
+
+    const uint8_t sequence = nextSequence++;
+
+    // Sequenced CRC-16 frame: marker, address, sequence, code, size, payload, CRC, NULL
+    std::vector<uint8_t> frame = { FRAME_SEQ_START_MARKER, PLC_NODE_ADDRESS, sequence };
+    frame.insert(frame.end(), request.frame.begin(), request.frame.end());
+
+    const uint16_t crc = crc16(frame.data() + 1, frame.size() - 1);
+    frame.push_back(crc >> 8);
+    frame.push_back(crc & 0xFF);
+    frame.push_back(0);
+
+    for (const uint8_t byte : frame) lastClientByte = hostClientWrite(byte);
+
+    inFlightRequests[sequence] = { request.frame[0], request.generatedTime, lastClientByte };
+    results.sent++;
+}
+
+static void handleResponse(uint8_t sequence, uint8_t code, const std::vector<uint8_t>& payload) {
+    auto request = inFlightRequests.find(sequence);
+    if (request == inFlightRequests.end()) {
+        results.unmatched++;
+        return;
+    }
+
+    const uint64_t now = hostLastNodeByteTime();
+    results.turnaroundTimes.push_back(now - request->second.sentTime);
+    results.latencyTimes.push_back(now - request->second.generatedTime);
+
+    if (code == FRAME_NAK_CODE) {
+        results.naks++;
+        results.nakReasons[payload.size() > 1 ? payload[1] : 0]++;
+    }
+    else {
+        results.completed++;
+        if (code == GET_CHANGES_SINCE_ADDR && payload.size() >= 4) memcpy(&changeVersion, payload.data(), 4);
+    }
+
+    inFlightRequests.erase(request);
+}
+
+static void receiveResponses() {
+    enum class State { IDLE, ADDRESS, SEQUENCE, CODE, SIZE, PAYLOAD, CRC_HIGH, CRC_LOW, TERMINATOR };
+
+    static State                state = State::IDLE;
+    static bool                 sequenced;
+    static uint8_t              sequence, code, size;
+    static uint16_t             crc;
+    static std::vector<uint8_t> header, payload;
+
+    int byte;
+    while ((byte = hostClientRead()) >= 0) {
+        switch (state) {
+            case State::IDLE:
+                if (byte == FRAME_START_MARKER || byte == FRAME_SEQ_START_MARKER) {
+                    sequenced = byte == FRAME_SEQ_START_MARKER;
+                    header.clear();
+                    payload.clear();
+                    state = State::ADDRESS;
+                }
+                break;
+            case State::ADDRESS:  header.push_back(byte); state = sequenced ? State::SEQUENCE : State::CODE;  break;
+            case State::SEQUENCE: header.push_back(byte); sequence = byte; state = State::CODE;             break;
+            case State::CODE:     header.push_back(byte); code     = byte; state = State::SIZE;             break;
+            case State::SIZE:
+                header.push_back(byte);
+                size  = byte;
+                state = size > 0 ? State::PAYLOAD : State::CRC_HIGH;
+                break;
+            case State::PAYLOAD:
+                payload.push_back(byte);
+                if (payload.size() == size) state = State::CRC_HIGH;
+                break;
+            case State::CRC_HIGH: crc = byte << 8; state = State::CRC_LOW;    break;
+            case State::CRC_LOW:  crc |= byte;     state = State::TERMINATOR; break;
+            case State::TERMINATOR: {
+                uint16_t expectedCrc = crc16(header.data(), header.size());
+                expectedCrc          = crc16(payload.data(), payload.size(), expectedCrc);
+
+                if (expectedCrc != crc || !sequenced) results.corrupted++;
+                else handleResponse(sequence, code, payload);
+
+                state = State::IDLE;
+                break;
+            }
+        }
+    }
+}
+
+static void dropTimedOutRequests() {
+    for (auto request = inFlightRequests.begin(); request != inFlightRequests.end();) {
+        if (hostMicros() > request->second.sentTime + (uint64_t) options.timeout * 1000) {
+            results.dropped++;
+            request = inFlightRequests.erase(request);
+        }
+        else request++;
+    }
+}
+
+
+
+// Report ***********************************************************************************************************************
+
+static double percentile(std::vector<uint64_t> values, double percentile) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[min(values.size() - 1, (size_t) (percentile / 100 * values.size()))];
+}
+
+static void printReport(double simulatedSeconds) {
+    const HostBusStatistics& bus = hostBusStatistics();
+    const uint32_t responded = results.completed + results.naks;
+
+    printf("Simulated time            %.1f s (%.0f ticks of %u us)\n", simulatedSeconds, simulatedSeconds * 1e6 / options.tickUs, options.tickUs);
+    printf("Offered load              %.1f requests/s (%s mix, window %u)\n", options.rate, options.pollOnly ? "poll" : "all", options.window);
+    printf("Requests                  %u generated, %u sent, %u completed, %u NAK, %u dropped, %u unsent\n", results.generated, results.sent, results.completed, results.naks, results.dropped, results.unsent);
+    printf("Throughput                %.1f requests/s\n", responded / simulatedSeconds);
+    printf("Drop rate                 %.2f %%\n", results.sent ? 100.0 * results.dropped / results.sent : 0.0);
+    printf("Turnaround p50/p99        %.0f/%.0f ticks (%.2f/%.2f ms)\n",
+        percentile(results.turnaroundTimes, 50) / options.tickUs, percentile(results.turnaroundTimes, 99) / options.tickUs,
+        percentile(results.turnaroundTimes, 50) / 1000,           percentile(results.turnaroundTimes, 99) / 1000);
+    printf("Latency p50/p99           %.2f/%.2f ms (max %zu pending)\n",
+        percentile(results.latencyTimes, 50) / 1000, percentile(results.latencyTimes, 99) / 1000, results.maxPending);
+    printf("Bus                       %u bytes sent, %u bytes received, %u collisions, %u PLC Rx overruns\n",
+        bus.clientBytesSent, bus.nodeBytesSent, bus.collisions, bus.nodeRxOverruns);
+    printf("Responses                 %u corrupted, %u unmatched\n", results.corrupted, results.unmatched);
+
+    const HostPowerStatistics& power = hostPowerStatistics();
+    const uint64_t asleepMicros = power.asleepMicros - setupPower.asleepMicros;
+    const uint64_t awakeMicros  = power.awakeMicros  - setupPower.awakeMicros;
+    printf("Idle sleep                %.1f %% of the time asleep (%.2f s asleep, %.2f s awake, %u sleeps)\n",
+        asleepMicros + awakeMicros ? 100.0 * asleepMicros / (asleepMicros + awakeMicros) : 0.0,
+        asleepMicros / 1e6, awakeMicros / 1e6, power.sleeps - setupPower.sleeps);
+
+    for (const auto& reason : results.nakReasons) {
+        printf("NAK reason 0x%X            %u\n", reason.first, reason.second);
+    }
+}
+
+
+
+int main(int argc, char** argv) {
+    if (!parseOptions(argc, argv)) {
+        printUsage();
+        return 1;
+    }
+
+    randomGenerator.seed(options.seed);
+    loadOperations();
+
+    setup();
+    setupPower = hostPowerStatistics();   // Only report the power statistics of the simulated run
+
+    const uint64_t startTime   = hostMicros();
+    const uint64_t endTime     = startTime + (uint64_t) (options.duration * 1e6);
+    const uint64_t drainTime   = endTime + (uint64_t) options.timeout * 1000;
+    std::exponential_distribution<double> interArrival(options.rate / 1e6);
+    uint64_t nextArrival = startTime + (uint64_t) interArrival(randomGenerator);
+
+    while (hostMicros() < endTime || ((!inFlightRequests.empty() || !pendingRequests.empty()) && hostMicros() < drainTime)) {
+        loop();
+
+        receiveResponses();
+        dropTimedOutRequests();
+
+        while (nextArrival <= hostMicros() && nextArrival < endTime) {
+            generateRequest();
+            nextArrival += max((uint64_t) 1, (uint64_t) interArrival(randomGenerator));
+        }
+
+        while (canSendRequest()) sendRequest();
+
+        hostAdvance(options.tickUs);
+    }
+
+    results.dropped += inFlightRequests.size();
+    results.unsent   = pendingRequests.size();
+
+    printReport((hostMicros() - startTime) / 1e6);
+    return 0;
+}
@@ -0,0 +1,75 @@
+/*
+  Arduino.h (host simulation stub)
+
+  Minimal subset of the Arduino AVR core used by the firmware, backed by the simulated clock, pins and serial link of
+  HostArduino.cpp.
+*/
+#ifndef Arduino_h
+#define Arduino_h
+
+// Standard headers are included before the min/max macros are defined, as the macros break them
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A6 20
+#define A7 21
+
+#define SERIAL_8N1            0x06
+#define SERIAL_TX_BUFFER_SIZE 64
+#define SERIAL_RX_BUFFER_SIZE 64
+
+#define PROGMEM
+#define memcpy_P            memcpy
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+
+#define _BV(bit) (1 << (bit))
+
+// The firmware runs in a single thread, without interrupts
+#define interrupts()
+#define noInterrupts()
+
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+int  analogRead(uint8_t pin);
+
+class HardwareSerial
+{
+    public:
+        void   begin(unsigned long baud, uint8_t config = SERIAL_8N1);
+        int    available();
+        int    read();
+        int    availableForWrite();
+        size_t write(uint8_t byte);
+        void   flush();
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,42 @@
+/*
+  EEPROM.h (host simulation stub)
+
+  In-memory EEPROM with the size of the ATmega328P EEPROM (erased to 0xFF).
+*/
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include <Arduino.h>
+
+#define E2END 0x3FF
+
+class EEPROMClass
+{
+    public:
+        EEPROMClass() { memset(data, 0xFF, sizeof(data)); }
+
+        uint8_t  read(int idx)                   { return data[idx]; }
+        void     write(int idx, uint8_t val)     { data[idx] = val; writes++; }
+        void     update(int idx, uint8_t val)    { if (data[idx] != val) write(idx, val); }
+        uint16_t length()                        { return E2END + 1; }
+
+        template<typename T> T& get(int idx, T& t) {
+            memcpy(&t, data + idx, sizeof(T));
+            return t;
+        }
+
+        template<typename T> const T& put(int idx, const T& t) {
+            const uint8_t* ptr = (const uint8_t*) &t;
+            for (size_t i = 0; i < sizeof(T); i++) update(idx + i, ptr[i]);
+            return t;
+        }
+
+        uint32_t writes = 0;    // Byte writes (EEPROM wear)
+
+    private:
+        uint8_t data[E2END + 1];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,65 @@
+/*
+  MAX485.h (host simulation stub)
+
+  Same interface as the jsanmigimeno/MAX485 library, forwarding to the simulated HardwareSerial. The transmit enable 
+  pin state is reported to the simulated bus, and the begin/end transmission delays advance the simulated clock.
+*/
+#ifndef MAX485_h
+#define MAX485_h
+
+#include <Arduino.h>
+
+void hostSetTransmitEnable(bool enabled);
+
+class MAX485
+{
+    public:
+        MAX485(
+            HardwareSerial& serial,
+            uint8_t         transmissionEnablePin,
+            uint32_t        baudRate,
+            uint8_t         config,
+            uint16_t        preTransmissionDelay,
+            uint16_t        postTransmissionDelay
+        ) :
+            serial(serial),
+            transmissionEnablePin(transmissionEnablePin),
+            baudRate(baudRate),
+            config(config),
+            preTransmissionDelay(preTransmissionDelay),
+            postTransmissionDelay(postTransmissionDelay)
+        {}
+
+        void begin() {
+            pinMode(transmissionEnablePin, OUTPUT);
+            digitalWrite(transmissionEnablePin, LOW);
+            serial.begin(baudRate, config);
+        }
+
+        int    available()          { return serial.available(); }
+        int    read()               { return serial.read(); }
+        size_t write(uint8_t byte)  { return serial.write(byte); }
+
+        void beginTransmission() {
+            digitalWrite(transmissionEnablePin, HIGH);
+            hostSetTransmitEnable(true);
+            delayMicroseconds(preTransmissionDelay);
+        }
+
+        void endTransmission() {
+            serial.flush();
+            delayMicroseconds(postTransmissionDelay);
+            digitalWrite(transmissionEnablePin, LOW);
+            hostSetTransmitEnable(false);
+        }
+
+    private:
+        HardwareSerial& serial;
+        const uint8_t   transmissionEnablePin;
+        const uint32_t  baudRate;
+        const uint8_t   config;
+        const uint16_t  preTransmissionDelay;
+        const uint16_t  postTransmissionDelay;
+};
+
+#endif
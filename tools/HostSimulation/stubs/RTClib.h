@@ -0,0 +1,93 @@
+/*
+  RTClib.h (host simulation stub)
+
+  DateTime/TimeSpan with the same interface as the Adafruit RTClib (the subset used by the firmware), and a DS3231
+  that counts the simulated time.
+*/
+#ifndef RTClib_h
+#define RTClib_h
+
+#include <Arduino.h>
+
+class TimeSpan
+{
+    public:
+        TimeSpan(int32_t seconds = 0) : _seconds(seconds) {}
+        TimeSpan(int16_t days, int8_t hours, int8_t minutes, int8_t seconds)
+            : _seconds((int32_t) days * 86400L + (int32_t) hours * 3600 + (int32_t) minutes * 60 + seconds) {}
+
+        int32_t totalseconds() const { return _seconds; }
+
+    private:
+        int32_t _seconds;
+};
+
+class DateTime
+{
+    public:
+        DateTime(uint32_t t = 946684800) : _unixtime(t) {}
+
+        DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0) {
+            // Days from civil (proleptic Gregorian calendar)
+            const int32_t  y   = (int32_t) year - (month <= 2);
+            const int32_t  era = y / 400;
+            const uint32_t yoe = (uint32_t) (y - era * 400);
+            const uint32_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+            const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+            const int32_t  days = era * 146097 + (int32_t) doe - 719468;
+
+            _unixtime = (uint32_t) days * 86400 + (uint32_t) hour * 3600 + (uint32_t) min * 60 + sec;
+        }
+
+        uint16_t year()   const { return civil().year; }
+        uint8_t  month()  const { return civil().month; }
+        uint8_t  day()    const { return civil().day; }
+        uint8_t  hour()   const { return (_unixtime / 3600) % 24; }
+        uint8_t  minute() const { return (_unixtime / 60) % 60; }
+        uint8_t  second() const { return _unixtime % 60; }
+
+        uint32_t unixtime() const { return _unixtime; }
+
+        DateTime operator+(const TimeSpan& span) const { return DateTime(_unixtime + span.totalseconds()); }
+        DateTime operator-(const TimeSpan& span) const { return DateTime(_unixtime - span.totalseconds()); }
+
+        bool operator<(const DateTime& right)  const { return _unixtime <  right._unixtime; }
+        bool operator>(const DateTime& right)  const { return _unixtime >  right._unixtime; }
+        bool operator<=(const DateTime& right) const { return _unixtime <= right._unixtime; }
+        bool operator>=(const DateTime& right) const { return _unixtime >= right._unixtime; }
+        bool operator==(const DateTime& right) const { return _unixtime == right._unixtime; }
+        bool operator!=(const DateTime& right) const { return _unixtime != right._unixtime; }
+
+    private:
+        uint32_t _unixtime;
+
+        struct Civil { uint16_t year; uint8_t month; uint8_t day; };
+
+        Civil civil() const {
+            // Civil from days (proleptic Gregorian calendar)
+            const int32_t  z   = (int32_t) (_unixtime / 86400) + 719468;
+            const int32_t  era = z / 146097;
+            const uint32_t doe = (uint32_t) (z - era * 146097);
+            const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+            const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+            const uint32_t mp  = (5 * doy + 2) / 153;
+            const uint8_t  d   = doy - (153 * mp + 2) / 5 + 1;
+            const uint8_t  m   = mp < 10 ? mp + 3 : mp - 9;
+
+            return { (uint16_t) ((int32_t) yoe + era * 400 + (m <= 2)), m, d };
+        }
+};
+
+uint32_t hostRtcTime();
+void     hostRtcAdjust(uint32_t time);
+
+class RTC_DS3231
+{
+    public:
+        bool     begin()                         { return true; }
+        bool     lostPower()                     { return false; }
+        DateTime now()                           { return DateTime(hostRtcTime()); }
+        void     adjust(const DateTime& dateTime){ hostRtcAdjust(dateTime.unixtime()); }
+};
+
+#endif
@@ -0,0 +1,11 @@
+/*
+  StaticThreadController.h (host simulation stub)
+
+  Included by the sketch but not used.
+*/
+#ifndef StaticThreadController_h
+#define StaticThreadController_h
+
+#include "Thread.h"
+
+#endif
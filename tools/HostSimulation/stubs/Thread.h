@@ -0,0 +1,62 @@
+/*
+  Thread.h (host simulation stub)
+
+  Same interface and scheduling semantics as the ArduinoThread library.
+*/
+#ifndef Thread_h
+#define Thread_h
+
+#include <Arduino.h>
+
+class Thread
+{
+    protected:
+        unsigned long interval;
+        unsigned long last_run;
+        unsigned long _cached_next_run;
+
+        void runned(unsigned long time) {
+            last_run         = time;
+            _cached_next_run = last_run + interval;
+        }
+
+        void runned() { runned(millis()); }
+
+        void (*_onRun)(void);
+
+    public:
+        int  ThreadID;
+        bool enabled;
+
+        Thread(void (*callback)(void) = nullptr, unsigned long _interval = 0) : _onRun(callback), enabled(true) {
+            static int nextThreadID = 1;
+            ThreadID = nextThreadID++;
+            last_run = millis();
+            setInterval(_interval);
+        }
+
+        virtual ~Thread() {}
+
+        virtual void setInterval(unsigned long _interval) {
+            interval         = _interval;
+            _cached_next_run = last_run + interval;
+        }
+
+        unsigned long getInterval() { return interval; }
+
+        virtual bool shouldRun(unsigned long time) {
+            // Signed difference handles the millis() overflow
+            return enabled && (long) (time - _cached_next_run) >= 0;
+        }
+
+        bool shouldRun() { return shouldRun(millis()); }
+
+        void onRun(void (*callback)(void)) { _onRun = callback; }
+
+        virtual void run() {
+            if (_onRun != nullptr) _onRun();
+            runned();
+        }
+};
+
+#endif
@@ -0,0 +1,84 @@
+/*
+  ThreadController.h (host simulation stub)
+
+  Same interface and scheduling semantics as the ArduinoThread library.
+*/
+#ifndef ThreadController_h
+#define ThreadController_h
+
+#include "Thread.h"
+
+#define MAX_THREADS 15
+
+class ThreadController: public Thread
+{
+    protected:
+        Thread* thread[MAX_THREADS];
+        int     cached_size;
+
+    public:
+        ThreadController(unsigned long _interval = 0) : Thread(nullptr, _interval), cached_size(0) {
+            clear();
+        }
+
+        void run() {
+            if (_onRun != nullptr) _onRun();
+
+            const unsigned long time = millis();
+            for (int i = 0; i < MAX_THREADS; i++) {
+                if (thread[i] != nullptr && thread[i]->shouldRun(time)) thread[i]->run();
+            }
+
+            runned();
+        }
+
+        bool add(Thread* _thread) {
+            for (int i = 0; i < MAX_THREADS; i++) {
+                if (thread[i] != nullptr && thread[i]->ThreadID == _thread->ThreadID) return true;
+            }
+            for (int i = 0; i < MAX_THREADS; i++) {
+                if (thread[i] == nullptr) {
+                    thread[i] = _thread;
+                    cached_size++;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void remove(Thread* _thread) {
+            for (int i = 0; i < MAX_THREADS; i++) {
+                if (thread[i] != nullptr && thread[i]->ThreadID == _thread->ThreadID) {
+                    thread[i] = nullptr;
+                    cached_size--;
+                    return;
+                }
+            }
+        }
+
+        void clear() {
+            for (int i = 0; i < MAX_THREADS; i++) thread[i] = nullptr;
+            cached_size = 0;
+        }
+
+        int size(bool cached = true) {
+            if (cached) return cached_size;
+
+            int size = 0;
+            for (int i = 0; i < MAX_THREADS; i++) {
+                if (thread[i] != nullptr) size++;
+            }
+            cached_size = size;
+            return cached_size;
+        }
+
+        Thread* get(int index) {
+            int pos = -1;
+            for (int i = 0; i < MAX_THREADS; i++) {
+                if (thread[i] != nullptr && ++pos == index) return thread[i];
+            }
+            return nullptr;
+        }
+};
+
+#endif
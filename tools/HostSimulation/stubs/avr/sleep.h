@@ -0,0 +1,21 @@
+/*
+  avr/sleep.h (host simulation stub)
+
+  Sleep functions of the AVR libc. 'sleep_cpu' does not stop the firmware: the simulation step that follows is 
+  accounted as time spent asleep (see hostSleep in HostSimulation.h).
+*/
+#ifndef avr_sleep_h
+#define avr_sleep_h
+
+#include <Arduino.h>
+
+#define SLEEP_MODE_IDLE 0
+
+void hostSleep();
+
+inline void set_sleep_mode(uint8_t)      {}
+inline void sleep_enable()               {}
+inline void sleep_disable()              {}
+inline void sleep_cpu()                  { hostSleep(); }
+
+#endif